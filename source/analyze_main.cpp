@@ -0,0 +1,264 @@
+#include "arguments.h"
+#include "board.h"
+#include "engine.h"
+#include "evaluation.h"
+#include "game_record.h"
+#include "notation.h"
+#include "search_trace.h"
+#include "timing.h"
+#include "transposition_table.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+
+namespace ReversiEngine {
+
+    namespace {
+        struct AnalysisTask {
+            size_t game = 0;
+            int32_t ply = 0;
+            Board board;
+            Cell played{-1, -1};
+        };
+
+        struct MoveAnalysis {
+            Cell best{-1, -1};
+            int32_t best_score = 0;
+            int32_t played_score = 0;
+            int64_t nodes = 0;
+            // The best moves with --multi-pv above 1.
+            std::vector<ScoredLine> lines;
+        };
+
+        // Adds the position before every move of the game (after an implicit pass, so the
+        // side to move is the mover).
+        void AddGame(const GameRecord& record, size_t game, std::vector<AnalysisTask>& tasks) {
+            Board board;
+            for (size_t i = 0; i < record.length; ++i) {
+                if (board.PossibleMovesMask().value == 0) {
+                    board = board.MakeMove(Cell{-1, -1});
+                }
+                tasks.push_back({game, static_cast<int32_t>(i) + 1, board, record.Move(i)});
+                board = board.MakeMove(record.Move(i));
+            }
+        }
+
+        // Reads a game archive, or else a text file with one move sequence per line.
+        bool LoadGames(const std::string& path, std::vector<AnalysisTask>& tasks,
+                       size_t& games) {
+            GameReader reader(path);
+            if (reader.IsOpen()) {
+                GameRecord record;
+                while (reader.Next(record)) {
+                    AddGame(record, games++, tasks);
+                }
+                return true;
+            }
+            std::ifstream in(path);
+            if (!in) {
+                return false;
+            }
+            std::string line;
+            while (std::getline(in, line)) {
+                if (line.empty() || line[0] == '#') {
+                    continue;
+                }
+                std::vector<Cell> moves;
+                Board board;
+                if (!ParseMoves(line, moves, board)) {
+                    std::cerr << "Illegal game: " << line << std::endl;
+                    return false;
+                }
+                GameRecord record;
+                for (const auto& cell : moves) {
+                    record.Append(cell);
+                }
+                AddGame(record, games++, tasks);
+            }
+            return true;
+        }
+
+        std::string ToJson(const AnalysisTask& task, const MoveAnalysis& analysis) {
+            std::ostringstream out;
+            out << "{\"game\": " << task.game + 1 << ", \"ply\": " << task.ply
+                << ", \"player\": \"" << (task.board.CurrentPlayer() == First ? 'x' : 'o')
+                << "\", \"move\": \"" << task.played << "\", \"score\": " << analysis.played_score
+                << ", \"best\": \"" << analysis.best << "\", \"best_score\": "
+                << analysis.best_score
+                << ", \"loss\": " << analysis.best_score - analysis.played_score;
+            if (!analysis.lines.empty()) {
+                out << ", \"lines\": [";
+                for (size_t i = 0; i < analysis.lines.size(); ++i) {
+                    out << (i ? ", " : "") << "{\"move\": \"" << analysis.lines[i].move
+                        << "\", \"score\": " << analysis.lines[i].score << "}";
+                }
+                out << "]";
+            }
+            out << "}";
+            return out.str();
+        }
+    }// namespace
+
+    int RunAnalysis(const Arguments& arguments) {
+        Board().InitPrecalc();
+        if (arguments.Has("weights") &&
+            !LoadEvaluationWeights(arguments.GetString("weights", ""))) {
+            std::cerr << "Can not load evaluation weights" << std::endl;
+            return 1;
+        }
+        std::vector<AnalysisTask> tasks;
+        size_t games = 0;
+        for (const auto& path : arguments.Positional()) {
+            if (!LoadGames(path, tasks, games)) {
+                std::cerr << "Can not load " << path << std::endl;
+                return 1;
+            }
+        }
+        SearchLimits limits;
+        limits.depth = static_cast<int32_t>(arguments.GetInt("depth", 8));
+        if (limits.depth < 1) {
+            std::cerr << "--depth must be at least 1" << std::endl;
+            return 1;
+        }
+        limits.multi_pv = static_cast<int32_t>(arguments.GetInt("multi-pv", 1));
+        auto threads = static_cast<int32_t>(arguments.GetInt(
+                "threads", std::max(1u, std::thread::hardware_concurrency())));
+        auto hash_megabytes = static_cast<size_t>(arguments.GetInt("hash", 64));
+        std::string shared_hash = arguments.GetString("shared-hash", "");
+        auto table = shared_hash.empty()
+                             ? std::make_unique<TranspositionTable>(hash_megabytes)
+                             : std::make_unique<TranspositionTable>(hash_megabytes, shared_hash);
+        if (!shared_hash.empty() && !table->Shared()) {
+            std::cerr << "Can not attach to shared memory " << shared_hash
+                      << ", using a private table" << std::endl;
+        }
+
+        std::unique_ptr<SearchTracer> tracer;
+        if (arguments.Has("trace")) {
+            tracer = std::make_unique<SearchTracer>(arguments.GetString("trace", ""),
+                                                    arguments.GetDouble("trace-rate", 1));
+            if (!tracer->IsOpen()) {
+                std::cerr << "Can not write " << arguments.GetString("trace", "") << std::endl;
+                return 1;
+            }
+        }
+
+        // Positions are handed out in game order, so the threads work on neighbouring
+        // positions of the same game and find each other's results in the shared table.
+        std::vector<MoveAnalysis> results(tasks.size());
+        std::atomic<size_t> next_task = 0;
+        auto start = std::chrono::steady_clock::now();
+        auto worker = [&]() {
+            Engine engine;
+            engine.transposition_table = table.get();
+            if (tracer) {
+                engine.trace = tracer->CreateBuffer();
+            }
+            for (size_t i = next_task++; i < tasks.size(); i = next_task++) {
+                const AnalysisTask& task = tasks[i];
+                MoveAnalysis& result = results[i];
+                SearchResult search = engine.Search(task.board, limits);
+                result.best = search.move;
+                result.best_score = search.score;
+                result.nodes = search.nodes;
+                auto played_line = std::find_if(
+                        search.lines.begin(), search.lines.end(),
+                        [&](const ScoredLine& line) { return line.move == task.played; });
+                if (task.played == search.move) {
+                    result.played_score = search.score;
+                } else if (played_line != search.lines.end()) {
+                    result.played_score = played_line->score;
+                } else {
+                    result.played_score = engine.ScoreMove(task.board, task.played, search.depth);
+                    result.nodes += engine.nodes;
+                }
+                // Deeper results from the shared table can make the played move look better
+                // than the root search's choice; then it is the best move found.
+                if (result.played_score > result.best_score) {
+                    result.best = task.played;
+                    result.best_score = result.played_score;
+                }
+                result.lines = std::move(search.lines);
+            }
+        };
+        std::vector<std::jthread> workers;
+        for (int32_t i = 0; i < threads; ++i) {
+            workers.emplace_back(worker);
+        }
+        workers.clear();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        std::ofstream output;
+        if (arguments.Has("output")) {
+            output.open(arguments.GetString("output", ""));
+            if (!output) {
+                std::cerr << "Can not write " << arguments.GetString("output", "") << std::endl;
+                return 1;
+            }
+        }
+        int64_t nodes = 0;
+        // Total loss and number of moves of each player in the current game.
+        std::array<int64_t, 2> loss{};
+        std::array<int64_t, 2> moves{};
+        for (size_t i = 0; i < tasks.size(); ++i) {
+            const AnalysisTask& task = tasks[i];
+            const MoveAnalysis& result = results[i];
+            nodes += result.nodes;
+            if (output.is_open()) {
+                output << ToJson(task, result) << "\n";
+            }
+            loss[task.board.CurrentPlayer()] += result.best_score - result.played_score;
+            ++moves[task.board.CurrentPlayer()];
+            if (i + 1 == tasks.size() || tasks[i + 1].game != task.game) {
+                auto average = [&](Player player) {
+                    return static_cast<double>(loss[player]) /
+                           static_cast<double>(std::max<int64_t>(moves[player], 1));
+                };
+                std::cout << std::fixed << std::setprecision(2) << "Game " << task.game + 1
+                          << ": average loss x " << average(First) << ", o " << average(Second)
+                          << std::defaultfloat << std::endl;
+                loss = {};
+                moves = {};
+            }
+        }
+        std::cout << "Analyzed " << tasks.size() << " positions of " << games << " games in "
+                  << elapsed.count() << " sec, " << nodes << " nodes ("
+                  << static_cast<int64_t>(static_cast<double>(nodes) /
+                                          std::max(elapsed.count(), 1e-9))
+                  << " nodes/sec)" << std::endl;
+        std::cout << FormatTimings(CollectTimings()) << std::flush;
+        return 0;
+    }
+
+}// namespace ReversiEngine
+
+int main(int argc, char** argv) {
+    ReversiEngine::Arguments arguments(argc, argv);
+    if (arguments.Has("help") || arguments.Positional().empty()) {
+        std::cout << "Usage: reversi-analyze FILE... [--depth=8] [--threads=N] [--hash=MB]\n"
+                     "                       [--shared-hash=NAME] [--multi-pv=K] [--output=FILE]\n"
+                     "                       [--weights=FILE] [--trace=FILE [--trace-rate=R]]\n"
+                     "Searches every position of the games (a game archive or a text file\n"
+                     "with one move sequence per line) and prints the average loss of each\n"
+                     "player. --output writes the score of the played move, the best move,\n"
+                     "its score and the loss of every move as JSON lines. Scores are in\n"
+                     "evaluation units from the mover's point of view. --shared-hash puts the\n"
+                     "table in a shared-memory segment such as /reversi-tt, used by every\n"
+                     "process given the same name; it stays until removed from /dev/shm.\n"
+                     "--multi-pv adds the K best moves with their scores to the output.\n"
+                     "--trace records the search trees of an R fraction of the positions for\n"
+                     "reversi-trace."
+                  << std::endl;
+        return arguments.Has("help") ? 0 : 1;
+    }
+    return ReversiEngine::RunAnalysis(arguments);
+}
@@ -0,0 +1,62 @@
+#include "arguments.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+
+namespace ReversiEngine {
+
+    namespace {
+        template<typename T>
+        T ParseValue(const std::string& name, const std::string& text) {
+            std::istringstream in(text);
+            T value{};
+            if (!(in >> value) || !(in >> std::ws).eof()) {
+                std::cerr << "Invalid value for --" << name << ": \"" << text << "\"" << std::endl;
+                std::exit(1);
+            }
+            return value;
+        }
+    }// namespace
+
+    Arguments::Arguments(int argc, char** argv) {
+        for (int i = 1; i < argc; ++i) {
+            std::string argument = argv[i];
+            if (argument.rfind("--", 0) != 0) {
+                positional_.push_back(argument);
+                continue;
+            }
+            auto equals = argument.find('=');
+            if (equals == std::string::npos) {
+                options_[argument.substr(2)] = "";
+            } else {
+                options_[argument.substr(2, equals - 2)] = argument.substr(equals + 1);
+            }
+        }
+    }
+
+    bool Arguments::Has(const std::string& name) const {
+        return options_.contains(name);
+    }
+
+    std::string Arguments::GetString(const std::string& name,
+                                     const std::string& default_value) const {
+        auto it = options_.find(name);
+        return it == options_.end() ? default_value : it->second;
+    }
+
+    int64_t Arguments::GetInt(const std::string& name, int64_t default_value) const {
+        auto it = options_.find(name);
+        return it == options_.end() ? default_value : ParseValue<int64_t>(name, it->second);
+    }
+
+    double Arguments::GetDouble(const std::string& name, double default_value) const {
+        auto it = options_.find(name);
+        return it == options_.end() ? default_value : ParseValue<double>(name, it->second);
+    }
+
+    const std::vector<std::string>& Arguments::Positional() const {
+        return positional_;
+    }
+
+}// namespace ReversiEngine
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ReversiEngine {
+
+    // Minimal command line parser for the tools: options are written as "--name=value" or
+    // "--name" (a flag), everything else is positional.
+    class Arguments {
+    public:
+        Arguments(int argc, char** argv);
+
+        [[nodiscard]] bool Has(const std::string& name) const;
+
+        [[nodiscard]] std::string GetString(const std::string& name,
+                                            const std::string& default_value) const;
+
+        // The numeric getters print a usage error and exit with status 1 if the value is not a
+        // number.
+        [[nodiscard]] int64_t GetInt(const std::string& name, int64_t default_value) const;
+
+        [[nodiscard]] double GetDouble(const std::string& name, double default_value) const;
+
+        [[nodiscard]] const std::vector<std::string>& Positional() const;
+
+    private:
+        std::unordered_map<std::string, std::string> options_;
+        std::vector<std::string> positional_;
+    };
+
+}// namespace ReversiEngine
@@ -0,0 +1,371 @@
+#include "arguments.h"
+#include "board.h"
+#include "engine.h"
+#include "huge_pages.h"
+#include "json.h"
+#include "network.h"
+#include "perf_counters.h"
+#include "playout.h"
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <optional>
+#include <random>
+#include <sstream>
+
+namespace ReversiEngine {
+
+    namespace {
+        struct Phase {
+            const char* name;
+            int32_t min_discs;
+            int32_t max_discs;
+        };
+
+        const std::array<Phase, 3> PHASES = {
+                Phase{"opening", 5, 20},
+                Phase{"midgame", 21, 44},
+                Phase{"endgame", 45, 60},
+        };
+
+        struct BenchmarkResult {
+            std::string name;
+            std::string phase;
+            int64_t operations = 0;
+            double ns_per_op = 0;
+            std::string counters;
+        };
+
+        struct Measurement {
+            double ns_per_op = 0;
+            std::string counters;
+        };
+
+        // Random games from a fixed seed; every position whose disc count falls into the phase
+        // is sampled. std::mt19937_64 is fully specified, so the corpus is the same everywhere.
+        std::vector<Board> GenerateCorpus(const Phase& phase, size_t size, uint64_t seed) {
+            std::mt19937_64 random(seed);
+            std::vector<Board> corpus;
+            std::vector<Cell> moves;
+            while (corpus.size() < size) {
+                Board board;
+                int32_t discs = 4;
+                while (discs <= phase.max_discs) {
+                    board.PossibleMoves(moves);
+                    if (moves.empty()) {
+                        board = board.MakeMove(Cell{-1, -1});
+                        board.PossibleMoves(moves);
+                        if (moves.empty()) {
+                            break;
+                        }
+                    }
+                    board = board.MakeMove(moves[random() % moves.size()]);
+                    ++discs;
+                    if (discs >= phase.min_discs && discs <= phase.max_discs &&
+                        !board.PossibleMoves().empty() && random() % 4 == 0) {
+                        corpus.push_back(board);
+                        if (corpus.size() == size) {
+                            break;
+                        }
+                    }
+                }
+            }
+            return corpus;
+        }
+
+        volatile int64_t sink = 0;
+
+        // Runs `body` (which performs `operations` operations and returns a checksum) until at
+        // least `min_seconds` have passed and reports the best of the repetitions. With `perf`
+        // the hardware counters of all repetitions are reported per operation.
+        template<typename Body>
+        Measurement Measure(Body&& body, int64_t operations, double min_seconds, bool perf) {
+            std::optional<PerfCounters> counters;
+            if (perf) {
+                counters.emplace();
+                counters->Start();
+            }
+            double best = std::numeric_limits<double>::max();
+            std::chrono::duration<double> total{0};
+            int32_t repetitions = 0;
+            while (total.count() < min_seconds || repetitions < 3) {
+                auto start = std::chrono::steady_clock::now();
+                sink = sink + body();
+                std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+                total += elapsed;
+                best = std::min(best, elapsed.count());
+                ++repetitions;
+            }
+            Measurement measurement;
+            measurement.ns_per_op = best * 1e9 / static_cast<double>(operations);
+            if (counters) {
+                counters->Stop();
+                measurement.counters =
+                        counters->Read().Format(operations * repetitions, total.count());
+            }
+            return measurement;
+        }
+
+        // Whether the benchmark `name` runs under --filter.
+        bool Selected(const std::string& name, const std::string& filter) {
+            return name.find(filter) != std::string::npos;
+        }
+
+        // Runs the benchmarks of `phase` that `filter` selects, preparing only what they use.
+        // `table` may be null when TranspositionTable::Probe is not selected.
+        std::vector<BenchmarkResult> RunPhase(const Phase& phase, size_t corpus_size,
+                                              double min_seconds, int32_t search_depth,
+                                              TranspositionTable* table, bool perf,
+                                              const std::string& filter) {
+            std::vector<Board> corpus = GenerateCorpus(phase, corpus_size, 20230101);
+            std::vector<std::pair<size_t, Cell>> moves;
+            for (size_t i = 0; i < corpus.size(); ++i) {
+                for (const auto& cell : corpus[i].PossibleMoves()) {
+                    moves.emplace_back(i, cell);
+                }
+            }
+            auto n = static_cast<int64_t>(corpus.size());
+            auto m = static_cast<int64_t>(moves.size());
+            std::vector<BenchmarkResult> results;
+            auto run = [&](const std::string& name, int64_t operations, auto&& body) {
+                if (!Selected(name, filter)) {
+                    return;
+                }
+                Measurement measurement = Measure(body, operations, min_seconds, perf);
+                results.push_back({name, phase.name, operations, measurement.ns_per_op,
+                                   measurement.counters});
+            };
+
+            std::vector<Cell> buffer;
+            buffer.reserve(64);
+            run("Board::PossibleMoves", n, [&]() {
+                int64_t checksum = 0;
+                for (const auto& board : corpus) {
+                    board.PossibleMoves(buffer);
+                    checksum += static_cast<int64_t>(buffer.size());
+                }
+                return checksum;
+            });
+            run("Board::PossibleMovesMask", n, [&]() {
+                int64_t checksum = 0;
+                for (const auto& board : corpus) {
+                    checksum += std::popcount(board.PossibleMovesMask().value);
+                }
+                return checksum;
+            });
+            run("Board::MakeMove", m, [&]() {
+                int64_t checksum = 0;
+                for (const auto& [index, cell] : moves) {
+                    checksum += corpus[index].MakeMove(cell).DiscDifference();
+                }
+                return checksum;
+            });
+            run("Board::MakeMoveLast", m, [&]() {
+                int64_t checksum = 0;
+                for (const auto& [index, cell] : moves) {
+                    checksum += corpus[index].MakeMoveLast(cell).DiscDifference();
+                }
+                return checksum;
+            });
+            run("Board::FinalEvaluation", n, [&]() {
+                int64_t checksum = 0;
+                for (const auto& board : corpus) {
+                    checksum += board.FinalEvaluation();
+                }
+                return checksum;
+            });
+
+            std::vector<Board> children;
+            for (const auto& [index, cell] : moves) {
+                children.push_back(corpus[index].MakeMove(cell));
+            }
+            if (Selected("Network::Update", filter) || Selected("Network::Evaluate", filter)) {
+                // Zero weights: the cost does not depend on the weight values.
+                auto network = std::make_unique<Network>();
+                std::vector<NetworkAccumulator> accumulators(corpus.size());
+                for (size_t i = 0; i < corpus.size(); ++i) {
+                    network->Update(accumulators[i], corpus[i]);
+                }
+                NetworkAccumulator child;
+                run("Network::Update", m, [&]() {
+                    int64_t checksum = 0;
+                    for (size_t i = 0; i < moves.size(); ++i) {
+                        network->Update(accumulators[moves[i].first], child, children[i]);
+                        checksum += child.values[First][0];
+                    }
+                    return checksum;
+                });
+                run("Network::Evaluate", n, [&]() {
+                    int64_t checksum = 0;
+                    for (size_t i = 0; i < corpus.size(); ++i) {
+                        checksum += network->Evaluate(accumulators[i], corpus[i].CurrentPlayer());
+                    }
+                    return checksum;
+                });
+            }
+
+            std::vector<PlayoutPosition> positions(corpus.begin(), corpus.end());
+            std::vector<int32_t> playout_results(positions.size());
+            Xorshift64 random(20230101);
+            run("Playout", n, [&]() {
+                int64_t checksum = 0;
+                for (const auto& position : positions) {
+                    checksum += Playout(position, random);
+                }
+                return checksum;
+            });
+            run("PlayoutBatch", n, [&]() {
+                PlayoutBatch(positions.data(), playout_results.data(), positions.size(), random);
+                int64_t checksum = 0;
+                for (int32_t result : playout_results) {
+                    checksum += result;
+                }
+                return checksum;
+            });
+
+            if (Selected("TranspositionTable::Probe", filter)) {
+                // Random probes of a table far larger than the TLB reach of normal pages.
+                table->Clear();
+                std::vector<uint64_t> keys(moves.size());
+                for (size_t i = 0; i < moves.size(); ++i) {
+                    keys[i] = children[i].Hash();
+                    table->Store(keys[i], {static_cast<int16_t>(i), 1, TranspositionTable::Exact,
+                                           static_cast<uint8_t>(moves[i].second.ToInt())});
+                }
+                run("TranspositionTable::Probe", m, [&]() {
+                    int64_t checksum = 0;
+                    TranspositionTable::Entry entry;
+                    for (uint64_t key : keys) {
+                        checksum += table->Probe(key, entry) ? entry.score : 0;
+                    }
+                    return checksum;
+                });
+            }
+
+            Engine engine;
+            size_t searched = std::min<size_t>(corpus.size(), 256);
+            run("Engine::SmartEvaluation/depth=" + std::to_string(search_depth),
+                static_cast<int64_t>(searched), [&]() {
+                    int64_t checksum = 0;
+                    for (size_t i = 0; i < searched; ++i) {
+                        checksum += engine.SmartEvaluation(corpus[i], search_depth, -10000, 10000);
+                    }
+                    return checksum;
+                });
+            return results;
+        }
+
+        std::string ToJson(const std::vector<BenchmarkResult>& results) {
+            std::ostringstream out;
+            out << std::fixed << std::setprecision(3) << "[\n";
+            for (size_t i = 0; i < results.size(); ++i) {
+                const auto& result = results[i];
+                out << "  {\"name\": \"" << result.name << "\", \"phase\": \"" << result.phase
+                    << "\", \"operations\": " << result.operations
+                    << ", \"ns_per_op\": " << result.ns_per_op
+                    << ", \"ops_per_sec\": " << 1e9 / result.ns_per_op;
+                if (!result.counters.empty()) {
+                    out << ", \"counters\": \"" << result.counters << "\"";
+                }
+                out << "}"
+                    << (i + 1 == results.size() ? "\n" : ",\n");
+            }
+            out << "]\n";
+            return out.str();
+        }
+
+        // Reads back the JSON written by ToJson (one benchmark per line).
+        std::map<std::string, double> LoadBaseline(const std::string& path) {
+            std::map<std::string, double> baseline;
+            std::ifstream in(path);
+            std::string line;
+            while (std::getline(in, line)) {
+                std::string name = JsonField(line, "name");
+                std::string ns_per_op = JsonField(line, "ns_per_op");
+                if (!name.empty() && !ns_per_op.empty()) {
+                    baseline[name + " " + JsonField(line, "phase")] = std::stod(ns_per_op);
+                }
+            }
+            return baseline;
+        }
+    }// namespace
+
+    int RunBenchmarks(const Arguments& arguments) {
+        Board().InitPrecalc();
+        auto corpus_size = static_cast<size_t>(arguments.GetInt("positions", 4096));
+        double min_seconds = arguments.GetDouble("min-time", 0.2);
+        auto search_depth = static_cast<int32_t>(arguments.GetInt("search-depth", 3));
+        std::string filter = arguments.GetString("filter", "");
+        bool perf = arguments.Has("perf");
+        // Only allocated when its benchmark runs, so a filtered run stays cheap.
+        std::unique_ptr<TranspositionTable> table;
+        if (Selected("TranspositionTable::Probe", filter)) {
+            table = std::make_unique<TranspositionTable>(
+                    static_cast<size_t>(arguments.GetInt("hash", 256)));
+        }
+        std::cout << "Lookup tables on " << BackingName(TableArena::Instance().GetBacking())
+                  << std::endl;
+
+        std::map<std::string, double> baseline;
+        if (arguments.Has("compare")) {
+            baseline = LoadBaseline(arguments.GetString("compare", ""));
+        }
+
+        std::vector<BenchmarkResult> results;
+        std::cout << std::left << std::setw(40) << "benchmark" << std::setw(10) << "phase"
+                  << std::right << std::setw(12) << "ns/op" << std::setw(16) << "ops/sec"
+                  << (baseline.empty() ? "" : "      change") << std::endl;
+        for (const auto& phase : PHASES) {
+            for (const auto& result : RunPhase(phase, corpus_size, min_seconds, search_depth,
+                                               table.get(), perf, filter)) {
+                std::cout << std::left << std::setw(40) << result.name << std::setw(10)
+                          << result.phase << std::right << std::fixed << std::setprecision(2)
+                          << std::setw(12) << result.ns_per_op << std::setw(16)
+                          << std::setprecision(0) << 1e9 / result.ns_per_op;
+                auto it = baseline.find(result.name + " " + result.phase);
+                if (it != baseline.end()) {
+                    std::cout << std::setw(11) << std::showpos << std::setprecision(1)
+                              << 100 * (result.ns_per_op / it->second - 1) << "%"
+                              << std::noshowpos;
+                }
+                std::cout << std::endl;
+                if (!result.counters.empty()) {
+                    std::cout << "    " << result.counters << std::endl;
+                }
+                results.push_back(result);
+            }
+        }
+        if (arguments.Has("json")) {
+            std::ofstream out(arguments.GetString("json", ""));
+            out << ToJson(results);
+            if (!out) {
+                std::cerr << "Can not write " << arguments.GetString("json", "") << std::endl;
+                return 1;
+            }
+        }
+        return 0;
+    }
+
+}// namespace ReversiEngine
+
+int main(int argc, char** argv) {
+    ReversiEngine::Arguments arguments(argc, argv);
+    if (arguments.Has("help")) {
+        std::cout << "Usage: reversi-bench [--positions=N] [--min-time=SEC] [--search-depth=N]\n"
+                     "                     [--filter=NAME] [--json=FILE] [--compare=FILE]\n"
+                     "                     [--perf] [--hash=256]\n"
+                     "Microbenchmarks of the board and search kernels on fixed opening, midgame\n"
+                     "and endgame corpora. --compare prints the change against a saved JSON,\n"
+                     "--perf adds hardware counters per operation. The lookup tables and the\n"
+                     "--hash MB transposition table are on huge pages where the system allows;\n"
+                     "run with REVERSI_HUGE_PAGES=0 to compare with normal pages."
+                  << std::endl;
+        return 0;
+    }
+    return ReversiEngine::RunBenchmarks(arguments);
+}
@@ -1,26 +1,22 @@
 #include "board.h"
+#include "evaluation.h"
+#include "huge_pages.h"
+#include "transposition_table.h"
 
+#include <algorithm>
 #include <array>
+#include <bit>
 
-std::array<Bitset8, 1 << 16> precalced_check_line;
-std::array<std::array<int32_t, 1 << 16>, 8> precalced_row_costs;
-std::array<std::array<Bitset8, 1 << 16>, 8> precalced_captures;
+// Both live in the table arena, on huge pages where available.
+auto& precalced_check_line =
+        ReversiEngine::TableArena::Instance().Create<std::array<Bitset8, 1 << 16>>();
+auto& precalced_captures =
+        ReversiEngine::TableArena::Instance().Create<std::array<std::array<Bitset8, 1 << 16>, 8>>();
 
 namespace ReversiEngine {
 
     namespace {
         // clang-format off
-        const std::array<uint8_t, 64> CONV_POSITION_ROW = {
-            100,  30,  30,  30,  30,  30,  30, 100,
-             30,   1,   1,   1,   1,   1,   1,  30,
-             30,   1,   1,   1,   1,   1,   1,  30,
-             30,   1,   1,   1,   1,   1,   1,  30,
-             30,   1,   1,   1,   1,   1,   1,  30,
-             30,   1,   1,   1,   1,   1,   1,  30,
-             30,   1,   1,   1,   1,   1,   1,  30,
-            100,  30,  30,  30,  30,  30,  30, 100
-        };
-
         const std::array<uint8_t, 64> CONV_POSITION_COL = {
                 0,  8, 16, 24, 32, 40, 48, 56,
                 1,  9, 17, 25, 33, 41, 49, 57,
@@ -167,26 +163,7 @@ namespace ReversiEngine {
                 precalced_check_line[(mask_first << 8) + mask_second] |= is_possible;
             }
         }
-        for (int32_t row = 0; row < 8; ++row) {
-            for (int32_t mask_first = 0; mask_first < (1 << 8); ++mask_first) {
-                for (int32_t mask_second = 0; mask_second < (1 << 8); ++mask_second) {
-                    if (mask_first & mask_second) {
-                        continue;
-                    }
-                    Bitset64 is_first(mask_first);
-                    Bitset64 is_second(mask_second);
-                    int32_t cost = 0;
-                    for (int32_t col = 0; col < 8; ++col) {
-                        if (is_first[col]) {
-                            cost += CONV_POSITION_ROW[(row << 3) + col];
-                        } else if (is_second[col]) {
-                            cost -= CONV_POSITION_ROW[(row << 3) + col];
-                        }
-                    }
-                    precalced_row_costs[row][(mask_first << 8) + mask_second] = cost;
-                }
-            }
-        }
+        SetEvaluationWeights(EvaluationWeights::Default());
         for (int32_t mask_first = 0; mask_first < (1 << 8); ++mask_first) {
             for (int32_t mask_second = 0; mask_second < (1 << 8); ++mask_second) {
                 if (mask_first & mask_second) {
@@ -244,9 +221,22 @@ namespace ReversiEngine {
         player_ = First;
     }
 
-    uint64_t counter = 0;
+    Board::Board(Bitset64 first, Bitset64 second, Player player) {
+        if (player == Second) {
+            std::swap(first, second);
+        }
+        for (size_t position = first._Find_first(); position < 64;
+             position = first._Find_next(position)) {
+            PlacePiece(position, First);
+        }
+        for (size_t position = second._Find_first(); position < 64;
+             position = second._Find_next(position)) {
+            PlacePiece(position, Second);
+        }
+        player_ = player;
+    }
+
     void Board::PlacePiece(size_t position, Player player) {
-        ++counter;
         if (player == First) {
             is_first_[position] = true;
             is_first_vertical[CONV_POSITION_COL[position]] = true;
@@ -261,7 +251,6 @@ namespace ReversiEngine {
     }
 
     inline void Board::PlacePiece(size_t position) {
-        ++counter;
         is_first_[position] = true;
         is_first_vertical[CONV_POSITION_COL[position]] = true;
         is_first_diagonal1[CONV_POSITION_DIAG1_POS[position]] = true;
@@ -390,6 +379,41 @@ namespace ReversiEngine {
         return (player_ == Player::First ? 'x' : 'o');
     }
 
+    Player Board::CurrentPlayer() const {
+        return player_;
+    }
+
+    Bitset64 Board::OwnDiscs() const {
+        return is_first_;
+    }
+
+    Bitset64 Board::OpponentDiscs() const {
+        return is_second_;
+    }
+
+    int32_t Board::DiscDifference() const {
+        return std::popcount(is_first_.to_ullong()) - std::popcount(is_second_.to_ullong());
+    }
+
+    int32_t Board::FinalScore() const {
+        int32_t difference = DiscDifference();
+        if (difference > 0) {
+            return difference + EmptyCount();
+        }
+        if (difference < 0) {
+            return difference - EmptyCount();
+        }
+        return 0;
+    }
+
+    int32_t Board::EmptyCount() const {
+        return 64 - std::popcount(is_first_.to_ullong() | is_second_.to_ullong());
+    }
+
+    uint64_t Board::Hash() const {
+        return PositionHash(is_first_.to_ullong(), is_second_.to_ullong());
+    }
+
     namespace {
         void BitsetToVector(const Bitset64& is_possible, std::vector<Cell>& result) {
             result.clear();
@@ -402,6 +426,10 @@ namespace ReversiEngine {
     }// namespace
 
     void Board::PossibleMoves(std::vector<Cell>& result) const {
+        BitsetToVector(PossibleMovesMask(), result);
+    }
+
+    Bitset64 Board::PossibleMovesMask() const {
         Bitset64 is_possible;
         auto value_first = is_first_.to_ullong();
         auto value_second = is_second_.to_ullong();
@@ -710,7 +738,7 @@ namespace ReversiEngine {
             }
         }
 
-        BitsetToVector(is_possible, result);
+        return is_possible;
     }
 
     bool Board::GameEnded() const {
@@ -749,15 +777,7 @@ namespace ReversiEngine {
     int32_t Board::FinalEvaluation() const {
         auto first = is_first_.to_ullong();
         auto second = is_second_.to_ullong();
-        int32_t res = 0;
-        for (int32_t row = 0; row < 8; ++row) {
-            int shift = 8 * row;
-            auto first_mask = (first >> shift) & ((1 << 8) - 1);
-            auto second_mask = (second >> shift) & ((1 << 8) - 1);
-            res += precalced_row_costs[(row == 0 || row == 7) ? 0 : 1]
-                                      [(first_mask << 8) + second_mask];
-        }
-        return res;
+        return EvaluateDiscs(first, second, EvaluationStage(std::popcount(first | second)));
     }
 
     Board Board::MakeMoveLast(const Cell& cell) const {
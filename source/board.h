@@ -13,18 +13,40 @@ namespace ReversiEngine {
     public:
         Board();
 
+        // Position with the given discs of the first (x) and second (o) player.
+        Board(Bitset64 first, Bitset64 second, Player player);
+
         void PossibleMoves(std::vector<Cell>& result) const;
 
         [[nodiscard]] std::vector<Cell> PossibleMoves() const;
 
+        [[nodiscard]] Bitset64 PossibleMovesMask() const;
+
         [[nodiscard]] char MySymbol() const;
 
+        [[nodiscard]] Player CurrentPlayer() const;
+
+        // Discs of the side to move and of its opponent.
+        [[nodiscard]] Bitset64 OwnDiscs() const;
+
+        [[nodiscard]] Bitset64 OpponentDiscs() const;
+
         [[nodiscard]] Board MakeMove(const Cell& cell) const;
 
         [[nodiscard]] Board MakeMoveLast(const Cell& cell) const;
 
         [[nodiscard]] int32_t FinalEvaluation() const;
 
+        [[nodiscard]] int32_t DiscDifference() const;
+
+        // Disc difference of a finished game with the empty squares given to the winner.
+        [[nodiscard]] int32_t FinalScore() const;
+
+        [[nodiscard]] int32_t EmptyCount() const;
+
+        // Hash of the discs from the side to move's point of view, for transposition tables.
+        [[nodiscard]] uint64_t Hash() const;
+
         [[nodiscard]] bool GameEnded() const;
 
         friend std::ostream& operator<<(std::ostream& os, const Board& board);
@@ -0,0 +1,381 @@
+#include "book.h"
+
+#include "engine.h"
+#include "transposition_table.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <queue>
+#include <thread>
+#include <tuple>
+
+namespace ReversiEngine {
+
+    namespace {
+        const char BOOK_MAGIC[4] = {'R', 'V', 'B', 'K'};
+        const uint32_t BOOK_VERSION = 1;
+        const uint8_t PASS_SQUARE = 64;
+        const int32_t SYMMETRIES = 8;
+
+        uint64_t FlipVertical(uint64_t bits) {
+            return __builtin_bswap64(bits);
+        }
+
+        uint64_t MirrorHorizontal(uint64_t bits) {
+            const uint64_t k1 = 0x5555555555555555ULL;
+            const uint64_t k2 = 0x3333333333333333ULL;
+            const uint64_t k4 = 0x0F0F0F0F0F0F0F0FULL;
+            bits = ((bits >> 1) & k1) | ((bits & k1) << 1);
+            bits = ((bits >> 2) & k2) | ((bits & k2) << 2);
+            return ((bits >> 4) & k4) | ((bits & k4) << 4);
+        }
+
+        // Swaps rows and columns.
+        uint64_t Transpose(uint64_t bits) {
+            const uint64_t k1 = 0x5500550055005500ULL;
+            const uint64_t k2 = 0x3333000033330000ULL;
+            const uint64_t k4 = 0x0F0F0F0F00000000ULL;
+            uint64_t t = k4 & (bits ^ (bits << 28));
+            bits ^= t ^ (t >> 28);
+            t = k2 & (bits ^ (bits << 14));
+            bits ^= t ^ (t >> 14);
+            t = k1 & (bits ^ (bits << 7));
+            return bits ^ t ^ (t >> 7);
+        }
+
+        // Symmetry 0 is the identity; bit 0 flips the rows, bit 1 the columns and bit 2
+        // transposes, in that order.
+        uint64_t Transform(uint64_t bits, int32_t symmetry) {
+            if (symmetry & 1) {
+                bits = FlipVertical(bits);
+            }
+            if (symmetry & 2) {
+                bits = MirrorHorizontal(bits);
+            }
+            if (symmetry & 4) {
+                bits = Transpose(bits);
+            }
+            return bits;
+        }
+
+        uint8_t TransformSquare(const Cell& cell, int32_t symmetry) {
+            if (cell.row < 0) {
+                return PASS_SQUARE;
+            }
+            return static_cast<uint8_t>(
+                    std::countr_zero(Transform(uint64_t{1} << cell.ToInt(), symmetry)));
+        }
+
+        Cell InverseSquare(uint8_t square, int32_t symmetry) {
+            for (int32_t original = 0; original < 64 && square != PASS_SQUARE; ++original) {
+                if (Transform(uint64_t{1} << original, symmetry) == uint64_t{1} << square) {
+                    return Cell{original >> 3, original & 7};
+                }
+            }
+            return Cell{-1, -1};
+        }
+
+        void PutInteger(std::ostream& out, uint64_t value, int32_t bytes) {
+            for (int32_t i = 0; i < bytes; ++i) {
+                out.put(static_cast<char>(value >> (8 * i)));
+            }
+        }
+
+        bool GetInteger(std::istream& in, uint64_t& value, int32_t bytes) {
+            value = 0;
+            for (int32_t i = 0; i < bytes; ++i) {
+                int byte = in.get();
+                if (byte == std::char_traits<char>::eof()) {
+                    return false;
+                }
+                value |= static_cast<uint64_t>(byte) << (8 * i);
+            }
+            return true;
+        }
+
+        // The legal moves of a position that is not finished, a pass if there are none.
+        std::vector<Cell> BookMoves(const Board& board) {
+            std::vector<Cell> moves = board.PossibleMoves();
+            if (moves.empty()) {
+                moves.push_back(Cell{-1, -1});
+            }
+            return moves;
+        }
+    }// namespace
+
+    size_t Book::KeyHash::operator()(const Key& key) const {
+        return PositionHash(key.own, key.opponent);
+    }
+
+    Book::Key Book::MakeKey(const Board& board, int32_t& symmetry) {
+        uint64_t own = board.OwnDiscs().to_ullong();
+        uint64_t opponent = board.OpponentDiscs().to_ullong();
+        Key best{own, opponent};
+        symmetry = 0;
+        for (int32_t candidate = 1; candidate < SYMMETRIES; ++candidate) {
+            Key key{Transform(own, candidate), Transform(opponent, candidate)};
+            if (key.own < best.own || (key.own == best.own && key.opponent < best.opponent)) {
+                best = key;
+                symmetry = candidate;
+            }
+        }
+        return best;
+    }
+
+    int32_t Book::MoveScore(const Key& key, const StoredMove& move) const {
+        Board board(Bitset64(key.own), Bitset64(key.opponent), First);
+        Cell cell = move.square == PASS_SQUARE ? Cell{-1, -1}
+                                               : Cell{move.square >> 3, move.square & 7};
+        int32_t symmetry;
+        auto child = nodes_.find(MakeKey(board.MakeMove(cell), symmetry));
+        return child == nodes_.end() ? move.score : -child->second.value;
+    }
+
+    void Book::Propagate() {
+        std::unordered_map<Key, bool, KeyHash> done;
+        // Positions only lead to positions with more discs or, after a pass, to the same discs
+        // with the other side to move, so the recursion ends.
+        std::function<int32_t(const Key&, Node&)> value = [&](const Key& key, Node& node) {
+            if (done[key]) {
+                return static_cast<int32_t>(node.value);
+            }
+            Board board(Bitset64(key.own), Bitset64(key.opponent), First);
+            int32_t best = std::numeric_limits<int16_t>::min();
+            for (const auto& move : node.moves) {
+                Cell cell = move.square == PASS_SQUARE ? Cell{-1, -1}
+                                                       : Cell{move.square >> 3, move.square & 7};
+                int32_t symmetry;
+                Key child_key = MakeKey(board.MakeMove(cell), symmetry);
+                auto child = nodes_.find(child_key);
+                best = std::max(best, child == nodes_.end() ? move.score
+                                                            : -value(child_key, child->second));
+            }
+            node.value = static_cast<int16_t>(best);
+            done[key] = true;
+            return best;
+        };
+        for (auto& [key, node] : nodes_) {
+            value(key, node);
+        }
+    }
+
+    std::vector<Book::Move> Book::Lookup(const Board& board) const {
+        std::vector<Move> moves;
+        int32_t symmetry;
+        Key key = MakeKey(board, symmetry);
+        auto node = nodes_.find(key);
+        if (node == nodes_.end()) {
+            return moves;
+        }
+        for (const auto& move : node->second.moves) {
+            moves.push_back({InverseSquare(move.square, symmetry), MoveScore(key, move)});
+        }
+        std::stable_sort(moves.begin(), moves.end(),
+                         [](const Move& lhs, const Move& rhs) { return lhs.score > rhs.score; });
+        return moves;
+    }
+
+    size_t Book::Size() const {
+        return nodes_.size();
+    }
+
+    int32_t Book::SearchDepth() const {
+        return search_depth_;
+    }
+
+    bool Book::Load(const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        char magic[sizeof(BOOK_MAGIC)];
+        uint64_t version;
+        uint64_t depth;
+        uint64_t count;
+        if (!in.read(magic, sizeof(magic)) || !std::equal(magic, magic + 4, BOOK_MAGIC) ||
+            !GetInteger(in, version, 4) || version != BOOK_VERSION || !GetInteger(in, depth, 4) ||
+            !GetInteger(in, count, 8)) {
+            return false;
+        }
+        std::unordered_map<Key, Node, KeyHash> nodes;
+        for (uint64_t i = 0; i < count; ++i) {
+            Key key;
+            uint64_t value;
+            uint64_t moves;
+            if (!GetInteger(in, key.own, 8) || !GetInteger(in, key.opponent, 8) ||
+                !GetInteger(in, value, 2) || !GetInteger(in, moves, 1)) {
+                return false;
+            }
+            Node& node = nodes[key];
+            node.value = static_cast<int16_t>(value);
+            node.moves.resize(moves);
+            for (auto& move : node.moves) {
+                uint64_t square;
+                uint64_t score;
+                if (!GetInteger(in, square, 1) || !GetInteger(in, score, 2)) {
+                    return false;
+                }
+                move.square = static_cast<uint8_t>(square);
+                move.score = static_cast<int16_t>(score);
+            }
+        }
+        nodes_ = std::move(nodes);
+        search_depth_ = static_cast<int32_t>(depth);
+        return true;
+    }
+
+    bool Book::Save(const std::string& path) const {
+        std::vector<const std::pair<const Key, Node>*> entries;
+        for (const auto& entry : nodes_) {
+            entries.push_back(&entry);
+        }
+        std::sort(entries.begin(), entries.end(), [](const auto* lhs, const auto* rhs) {
+            return std::tie(lhs->first.own, lhs->first.opponent) <
+                   std::tie(rhs->first.own, rhs->first.opponent);
+        });
+        std::string temporary = path + ".tmp";
+        {
+            std::ofstream out(temporary, std::ios::binary);
+            out.write(BOOK_MAGIC, sizeof(BOOK_MAGIC));
+            PutInteger(out, BOOK_VERSION, 4);
+            PutInteger(out, static_cast<uint32_t>(search_depth_), 4);
+            PutInteger(out, entries.size(), 8);
+            for (const auto* entry : entries) {
+                const auto& [key, node] = *entry;
+                PutInteger(out, key.own, 8);
+                PutInteger(out, key.opponent, 8);
+                PutInteger(out, static_cast<uint16_t>(node.value), 2);
+                PutInteger(out, node.moves.size(), 1);
+                for (const auto& move : node.moves) {
+                    PutInteger(out, move.square, 1);
+                    PutInteger(out, static_cast<uint16_t>(move.score), 2);
+                }
+            }
+            if (!out.flush()) {
+                return false;
+            }
+        }
+        return std::rename(temporary.c_str(), path.c_str()) == 0;
+    }
+
+    class BookBuilder {
+    public:
+        BookBuilder(Book& book, const BookSettings& settings)
+            : book_(book), settings_(settings), table_(settings.hash_megabytes) {
+        }
+
+        bool Run(const std::function<bool(const Book&)>& checkpoint) {
+            if (book_.search_depth_ != 0 && book_.search_depth_ != settings_.depth) {
+                return false;
+            }
+            while (book_.Size() < settings_.positions) {
+                std::vector<Board> positions = SelectPositions(
+                        std::min(settings_.batch, settings_.positions - book_.Size()));
+                if (positions.empty()) {
+                    break;
+                }
+                Expand(positions);
+                if (!checkpoint(book_)) {
+                    break;
+                }
+            }
+            return true;
+        }
+
+    private:
+        struct Candidate {
+            int32_t cost;
+            Board board;
+
+            bool operator>(const Candidate& other) const {
+                return cost > other.cost;
+            }
+        };
+
+        // The `count` cheapest positions outside the book that book moves lead to, found in
+        // order of cost from the initial position (Dijkstra's algorithm over the book).
+        std::vector<Board> SelectPositions(size_t count) {
+            std::vector<Board> selected;
+            std::unordered_map<Book::Key, int32_t, Book::KeyHash> costs;
+            std::priority_queue<Candidate, std::vector<Candidate>, std::greater<>> queue;
+            queue.push({0, Board()});
+            while (!queue.empty() && selected.size() < count) {
+                Candidate candidate = queue.top();
+                queue.pop();
+                int32_t symmetry;
+                Book::Key key = Book::MakeKey(candidate.board, symmetry);
+                auto known = costs.find(key);
+                if (known != costs.end()) {
+                    continue;
+                }
+                costs[key] = candidate.cost;
+                auto node = book_.nodes_.find(key);
+                if (node == book_.nodes_.end()) {
+                    if (!candidate.board.GameEnded()) {
+                        selected.push_back(candidate.board);
+                    }
+                    continue;
+                }
+                for (const auto& move : node->second.moves) {
+                    int32_t loss = node->second.value - book_.MoveScore(key, move);
+                    queue.push({candidate.cost + loss + settings_.ply_cost,
+                                candidate.board.MakeMove(InverseSquare(move.square, symmetry))});
+                }
+            }
+            return selected;
+        }
+
+        // Scores every move of the positions and adds them to the book.
+        void Expand(const std::vector<Board>& positions) {
+            struct Job {
+                size_t position;
+                Cell move;
+                int32_t score = 0;
+            };
+            std::vector<Job> jobs;
+            for (size_t i = 0; i < positions.size(); ++i) {
+                for (const auto& move : BookMoves(positions[i])) {
+                    jobs.push_back({i, move});
+                }
+            }
+            std::atomic<size_t> next_job = 0;
+            auto worker = [&]() {
+                Engine engine;
+                engine.transposition_table = &table_;
+                for (size_t i = next_job++; i < jobs.size(); i = next_job++) {
+                    jobs[i].score =
+                            engine.ScoreMove(positions[jobs[i].position], jobs[i].move,
+                                             settings_.depth);
+                }
+            };
+            {
+                std::vector<std::jthread> workers;
+                for (int32_t i = 0; i < std::max(settings_.threads, 1); ++i) {
+                    workers.emplace_back(worker);
+                }
+            }
+            for (size_t i = 0, job = 0; i < positions.size(); ++i) {
+                int32_t symmetry;
+                Book::Node& node = book_.nodes_[Book::MakeKey(positions[i], symmetry)];
+                for (; job < jobs.size() && jobs[job].position == i; ++job) {
+                    node.moves.push_back({TransformSquare(jobs[job].move, symmetry),
+                                          static_cast<int16_t>(jobs[job].score)});
+                }
+            }
+            book_.search_depth_ = settings_.depth;
+            book_.Propagate();
+        }
+
+        Book& book_;
+        const BookSettings& settings_;
+        TranspositionTable table_;
+    };
+
+    bool BuildBook(Book& book, const BookSettings& settings,
+                   const std::function<bool(const Book&)>& checkpoint) {
+        BookBuilder builder(book, settings);
+        return builder.Run(checkpoint);
+    }
+
+}// namespace ReversiEngine
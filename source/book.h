@@ -0,0 +1,105 @@
+#pragma once
+
+#include "board.h"
+#include "cell.h"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ReversiEngine {
+
+    // Opening book: positions reduced under the eight board symmetries, each with every legal
+    // move scored from the side to move. A move whose position is in the book takes the
+    // minimax value of that position; the others keep the score of their leaf search.
+    //
+    // The binary file is "RVBK", the version, the search depth (4 bytes each) and the number
+    // of positions (8), then for every position in key order: the discs of the side to move and
+    // of its opponent (8 bytes each), the minimax value (2), the move count (1) and every move
+    // as its square in the stored orientation (1, 64 for a pass) and its score (2). All
+    // integers are little-endian; a position with ten moves takes 49 bytes.
+    class Book {
+    public:
+        struct Move {
+            Cell cell{-1, -1};
+            int32_t score = 0;
+        };
+
+        [[nodiscard]] bool Load(const std::string& path);
+
+        // Writes a temporary file and renames it over `path`, so an interrupted write leaves
+        // the previous book.
+        [[nodiscard]] bool Save(const std::string& path) const;
+
+        // The moves of `board` with their minimax scores, best first; empty if the position is
+        // not in the book.
+        [[nodiscard]] std::vector<Move> Lookup(const Board& board) const;
+
+        [[nodiscard]] size_t Size() const;
+
+        [[nodiscard]] int32_t SearchDepth() const;
+
+    private:
+        friend class BookBuilder;
+
+        struct Key {
+            uint64_t own = 0;
+            uint64_t opponent = 0;
+
+            bool operator==(const Key& other) const = default;
+        };
+
+        struct KeyHash {
+            size_t operator()(const Key& key) const;
+        };
+
+        struct StoredMove {
+            uint8_t square = 0;// 64 for a pass
+            int16_t score = 0;
+        };
+
+        struct Node {
+            int16_t value = 0;
+            std::vector<StoredMove> moves;
+        };
+
+        // The key of `board` and the symmetry that turns `board` into the stored orientation.
+        [[nodiscard]] static Key MakeKey(const Board& board, int32_t& symmetry);
+
+        // Minimax values of all positions from their move scores and each other.
+        void Propagate();
+
+        // Score of a move of the position `key`: the value of the position it leads to if that
+        // is in the book, else its search score.
+        [[nodiscard]] int32_t MoveScore(const Key& key, const StoredMove& move) const;
+
+        std::unordered_map<Key, Node, KeyHash> nodes_;
+        int32_t search_depth_ = 0;
+    };
+
+    struct BookSettings {
+        // Depth of the searches that score the moves of a new book position.
+        int32_t depth = 12;
+        int32_t threads = 1;
+        size_t hash_megabytes = 256;
+        // The book grows until it has this many positions.
+        size_t positions = 1000;
+        // Positions added per round, between two checkpoints.
+        size_t batch = 64;
+        // Drop-out expansion adds the positions with the lowest cost: the sum of the score
+        // losses of the moves from the initial position to them plus `ply_cost` per move.
+        int32_t ply_cost = 20;
+    };
+
+    // Grows `book` from the initial position by drop-out expansion. Every round picks the
+    // settings.batch cheapest positions reachable through book moves, scores all their moves
+    // with searches spread over settings.threads engines sharing one transposition table, and
+    // propagates the minimax values back to the root. `checkpoint` is called after every round
+    // and stops the build by returning false. The book's search depth must be 0 (empty) or
+    // settings.depth.
+    [[nodiscard]] bool BuildBook(Book& book, const BookSettings& settings,
+                                 const std::function<bool(const Book&)>& checkpoint);
+
+}// namespace ReversiEngine
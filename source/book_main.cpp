@@ -0,0 +1,122 @@
+#include "arguments.h"
+#include "board.h"
+#include "book.h"
+#include "evaluation.h"
+#include "notation.h"
+
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <thread>
+
+namespace ReversiEngine {
+
+    namespace {
+        int BuildCommand(const Arguments& arguments, const std::string& path) {
+            BookSettings settings;
+            settings.depth = static_cast<int32_t>(arguments.GetInt("depth", settings.depth));
+            settings.threads = static_cast<int32_t>(arguments.GetInt(
+                    "threads", std::max(1u, std::thread::hardware_concurrency())));
+            settings.hash_megabytes = static_cast<size_t>(arguments.GetInt("hash", 256));
+            settings.positions = static_cast<size_t>(arguments.GetInt("positions", 1000));
+            settings.batch = static_cast<size_t>(
+                    arguments.GetInt("batch", 4 * static_cast<int64_t>(settings.threads)));
+            settings.ply_cost = static_cast<int32_t>(arguments.GetInt("ply-cost", 20));
+            if (settings.depth < 1) {
+                std::cerr << "--depth must be at least 1" << std::endl;
+                return 1;
+            }
+
+            Book book;
+            if (std::filesystem::exists(path)) {
+                if (!book.Load(path)) {
+                    std::cerr << "Can not read book " << path << std::endl;
+                    return 1;
+                }
+                std::cout << "Resuming with " << book.Size() << " positions" << std::endl;
+            }
+            auto start = std::chrono::steady_clock::now();
+            bool saved = true;
+            auto checkpoint = [&](const Book& current) {
+                saved = current.Save(path);
+                std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+                auto root = current.Lookup(Board());
+                std::cout << current.Size() << " positions, root value "
+                          << (root.empty() ? 0 : root.front().score) << " ("
+                          << elapsed.count() << " sec)" << std::endl;
+                if (!saved) {
+                    std::cerr << "Can not write " << path << std::endl;
+                }
+                return saved;
+            };
+            if (!BuildBook(book, settings, checkpoint)) {
+                std::cerr << "The book was built with --depth=" << book.SearchDepth() << std::endl;
+                return 1;
+            }
+            return saved ? 0 : 1;
+        }
+
+        int ProbeCommand(const Arguments& arguments, const std::string& path) {
+            Book book;
+            if (!book.Load(path)) {
+                std::cerr << "Can not read book " << path << std::endl;
+                return 1;
+            }
+            Board board;
+            std::vector<Cell> moves;
+            if (arguments.Has("position")) {
+                if (!ParsePosition(arguments.GetString("position", ""), board)) {
+                    std::cerr << "Can not parse position" << std::endl;
+                    return 1;
+                }
+            } else if (!ParseMoves(arguments.GetString("moves", ""), moves, board)) {
+                std::cerr << "Illegal moves: " << arguments.GetString("moves", "") << std::endl;
+                return 1;
+            }
+            std::cout << board << std::endl;
+            auto book_moves = book.Lookup(board);
+            if (book_moves.empty()) {
+                std::cout << "Not in the book (" << book.Size() << " positions)" << std::endl;
+                return 0;
+            }
+            for (const auto& move : book_moves) {
+                std::cout << move.cell << " " << move.score << "\n";
+            }
+            std::cout << std::flush;
+            return 0;
+        }
+    }// namespace
+
+    int RunBook(const Arguments& arguments) {
+        Board().InitPrecalc();
+        if (arguments.Has("weights") &&
+            !LoadEvaluationWeights(arguments.GetString("weights", ""))) {
+            std::cerr << "Can not load evaluation weights" << std::endl;
+            return 1;
+        }
+        const std::string& path = arguments.Positional().front();
+        return arguments.Has("build") ? BuildCommand(arguments, path)
+                                      : ProbeCommand(arguments, path);
+    }
+
+}// namespace ReversiEngine
+
+int main(int argc, char** argv) {
+    ReversiEngine::Arguments arguments(argc, argv);
+    if (arguments.Has("help") || arguments.Positional().empty()) {
+        std::cout << "Usage: reversi-book FILE --build [--depth=12] [--positions=1000]\n"
+                     "                    [--threads=N] [--batch=4*N] [--ply-cost=20]\n"
+                     "                    [--hash=256]\n"
+                     "       reversi-book FILE [--moves=f5d6... | --position=TEXT]\n"
+                     "--build grows the book in FILE from the initial position by drop-out\n"
+                     "expansion: every round adds the --batch positions with the lowest sum of\n"
+                     "score losses along the way plus --ply-cost per move, scores their moves\n"
+                     "with --depth searches on the threads and saves the book, so a stopped\n"
+                     "build resumes from the last round when run again. Without --build the\n"
+                     "book moves of the position are printed with their minimax scores from\n"
+                     "the mover's point of view. Both take [--weights=FILE]."
+                  << std::endl;
+        return arguments.Has("help") ? 0 : 1;
+    }
+    return ReversiEngine::RunBook(arguments);
+}
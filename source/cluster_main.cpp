@@ -0,0 +1,93 @@
+#include "arguments.h"
+#include "board.h"
+#include "distributed.h"
+#include "evaluation.h"
+#include "notation.h"
+
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace ReversiEngine {
+
+    namespace {
+        std::vector<std::string> SplitList(const std::string& text) {
+            std::vector<std::string> items;
+            std::istringstream in(text);
+            std::string item;
+            while (std::getline(in, item, ',')) {
+                if (!item.empty()) {
+                    items.push_back(item);
+                }
+            }
+            return items;
+        }
+    }// namespace
+
+    int RunCluster(const Arguments& arguments) {
+        Board board;
+        board.InitPrecalc();
+        if (arguments.Has("weights") &&
+            !LoadEvaluationWeights(arguments.GetString("weights", ""))) {
+            std::cerr << "Can not load evaluation weights" << std::endl;
+            return 1;
+        }
+        if (arguments.Has("worker")) {
+            return RunWorker(arguments.GetString("listen", "127.0.0.1"),
+                             static_cast<uint16_t>(arguments.GetInt("port", 7000)),
+                             static_cast<size_t>(arguments.GetInt("hash", 64)));
+        }
+
+        std::vector<Cell> moves;
+        if (arguments.Has("position")) {
+            if (!ParsePosition(arguments.GetString("position", ""), board)) {
+                std::cerr << "Can not parse position" << std::endl;
+                return 1;
+            }
+        } else if (!ParseMoves(arguments.GetString("moves", ""), moves, board)) {
+            std::cerr << "Illegal moves: " << arguments.GetString("moves", "") << std::endl;
+            return 1;
+        }
+        SearchLimits limits;
+        limits.depth =
+                arguments.Has("solve") ? 0 : static_cast<int32_t>(arguments.GetInt("depth", 10));
+        limits.milliseconds = arguments.GetInt("time", 0);
+        std::cout << board << std::endl;
+
+        auto start = std::chrono::steady_clock::now();
+        SearchResult result;
+        if (!DistributedSearch(board, limits, SplitList(arguments.GetString("workers", "")),
+                               result)) {
+            return 1;
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        std::cout << (arguments.Has("solve") ? "Score: " : "Evaluation: ") << result.score
+                  << ", best move: " << result.move << (result.depth == 0 ? " (stopped)" : "")
+                  << "\nSearched in " << elapsed.count() << " sec, " << result.nodes
+                  << " nodes ("
+                  << static_cast<int64_t>(static_cast<double>(result.nodes) /
+                                          std::max(elapsed.count(), 1e-9))
+                  << " nodes/sec)" << std::endl;
+        return 0;
+    }
+
+}// namespace ReversiEngine
+
+int main(int argc, char** argv) {
+    ReversiEngine::Arguments arguments(argc, argv);
+    if (arguments.Has("help") || (!arguments.Has("worker") && !arguments.Has("workers"))) {
+        std::cout << "Usage: reversi-cluster --worker [--port=7000] [--listen=127.0.0.1] "
+                     "[--hash=MB]\n"
+                     "       reversi-cluster --workers=HOST:PORT,... [--moves=f5d6... | "
+                     "--position=TEXT]\n"
+                     "                       [--depth=10 | --solve] [--time=MS]\n"
+                     "A worker scores the root moves the coordinator sends it; the coordinator\n"
+                     "splits the root of a search (or of an exact endgame solve) between the\n"
+                     "workers and prints the best move. Both take [--weights=FILE]."
+                  << std::endl;
+        return arguments.Has("help") ? 0 : 1;
+    }
+    return ReversiEngine::RunCluster(arguments);
+}
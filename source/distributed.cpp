@@ -0,0 +1,420 @@
+#include "distributed.h"
+#include "notation.h"
+#include "transposition_table.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <thread>
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace ReversiEngine {
+
+    namespace {
+        // Outside any score of the engine; the open end of a job's window.
+        const int32_t SCORE_BOUND = 10000;
+
+        class LineSocket {
+        public:
+            explicit LineSocket(int descriptor) : descriptor_(descriptor) {
+                int enable = 1;
+                setsockopt(descriptor_, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+            }
+
+            ~LineSocket() {
+                close(descriptor_);
+            }
+
+            LineSocket(const LineSocket&) = delete;
+
+            LineSocket& operator=(const LineSocket&) = delete;
+
+            [[nodiscard]] int Descriptor() const {
+                return descriptor_;
+            }
+
+            // Whether ReadLine returns without waiting for the socket.
+            [[nodiscard]] bool HasLine() const {
+                return buffer_.find('\n') != std::string::npos;
+            }
+
+            // Reads the next line without its newline; false at the end of the stream.
+            bool ReadLine(std::string& line) {
+                size_t end;
+                while ((end = buffer_.find('\n')) == std::string::npos) {
+                    char chunk[4096];
+                    ssize_t received = recv(descriptor_, chunk, sizeof(chunk), 0);
+                    if (received <= 0) {
+                        return false;
+                    }
+                    buffer_.append(chunk, static_cast<size_t>(received));
+                }
+                line = buffer_.substr(0, end);
+                buffer_.erase(0, end + 1);
+                return true;
+            }
+
+            bool Send(const std::string& line) {
+                std::string message = line + "\n";
+                for (size_t sent = 0; sent < message.size();) {
+                    ssize_t written = send(descriptor_, message.data() + sent,
+                                           message.size() - sent, MSG_NOSIGNAL);
+                    if (written <= 0) {
+                        return false;
+                    }
+                    sent += static_cast<size_t>(written);
+                }
+                return true;
+            }
+
+        private:
+            int descriptor_;
+            std::string buffer_;
+        };
+
+        // `worker` is "host:port"; returns -1 on failure.
+        int Connect(const std::string& worker) {
+            size_t colon = worker.rfind(':');
+            if (colon == std::string::npos) {
+                return -1;
+            }
+            addrinfo hints{};
+            hints.ai_family = AF_UNSPEC;
+            hints.ai_socktype = SOCK_STREAM;
+            addrinfo* addresses = nullptr;
+            if (getaddrinfo(worker.substr(0, colon).c_str(), worker.substr(colon + 1).c_str(),
+                            &hints, &addresses) != 0) {
+                return -1;
+            }
+            int descriptor = -1;
+            for (addrinfo* address = addresses; address && descriptor < 0;
+                 address = address->ai_next) {
+                descriptor =
+                        socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+                if (descriptor >= 0 &&
+                    connect(descriptor, address->ai_addr, address->ai_addrlen) != 0) {
+                    close(descriptor);
+                    descriptor = -1;
+                }
+            }
+            freeaddrinfo(addresses);
+            return descriptor;
+        }
+
+        Cell SquareCell(int32_t square) {
+            return square < 0 ? Cell{-1, -1} : Cell{square >> 3, square & 7};
+        }
+
+        struct Job {
+            int64_t id = 0;
+            int32_t depth = 0;
+            int32_t alpha = 0;
+            int32_t beta = 0;
+            Cell move{-1, -1};
+            Board board;
+        };
+
+        bool ParseJob(std::istringstream& in, Job& job) {
+            int32_t square;
+            std::string position;
+            std::string side;
+            if (!(in >> job.id >> job.depth >> job.alpha >> job.beta >> square >> position >>
+                  side)) {
+                return false;
+            }
+            job.move = SquareCell(square);
+            return ParsePosition(position + " " + side, job.board);
+        }
+
+        // Runs the jobs of one coordinator on a search thread while this thread reads the
+        // messages; a bound or a cancel stops the engine, and the search thread then restarts
+        // the job with the new alpha or reports it cancelled.
+        void Serve(LineSocket& connection, const Engine& engine) {
+            std::mutex mutex;
+            std::condition_variable wake;
+            std::optional<Job> job;
+            bool restart = false;
+            bool cancelled = false;
+            bool closing = false;
+            // Set with engine.stop; unlike it, not cleared when the next search starts.
+            std::atomic<bool> interrupt = false;
+
+            std::thread searcher([&]() {
+                std::unique_lock lock(mutex);
+                while (true) {
+                    wake.wait(lock, [&]() { return job || closing; });
+                    if (closing) {
+                        return;
+                    }
+                    int64_t nodes = 0;
+                    int32_t score = 0;
+                    Job current;
+                    while (true) {
+                        current = *job;
+                        restart = false;
+                        interrupt = false;
+                        lock.unlock();
+                        score = current.depth == 0
+                                        ? engine.SolveMove(current.board, current.move,
+                                                           current.alpha, current.beta, &interrupt)
+                                        : engine.ScoreMove(current.board, current.move,
+                                                           current.depth, current.alpha,
+                                                           current.beta, &interrupt);
+                        nodes += engine.nodes;
+                        lock.lock();
+                        if (!restart || cancelled || closing) {
+                            break;
+                        }
+                    }
+                    if (closing) {
+                        return;
+                    }
+                    std::ostringstream reply;
+                    if (cancelled) {
+                        reply << "cancelled " << current.id << " " << nodes;
+                    } else {
+                        reply << "result " << current.id << " " << score << " " << current.alpha
+                              << " " << nodes;
+                    }
+                    job.reset();
+                    cancelled = false;
+                    connection.Send(reply.str());
+                }
+            });
+
+            std::string line;
+            while (connection.ReadLine(line)) {
+                std::istringstream in(line);
+                std::string command;
+                in >> command;
+                std::lock_guard lock(mutex);
+                if (command == "job") {
+                    Job next;
+                    if (job || !ParseJob(in, next)) {
+                        std::cerr << "Bad job: " << line << std::endl;
+                        break;
+                    }
+                    job = next;
+                    wake.notify_one();
+                    continue;
+                }
+                int64_t id = 0;
+                in >> id;
+                if (!job || job->id != id) {
+                    continue;// finished already
+                }
+                if (command == "bound") {
+                    int32_t alpha = job->alpha;
+                    in >> alpha;
+                    if (alpha > job->alpha) {
+                        job->alpha = alpha;
+                        restart = true;
+                        interrupt = true;
+                        engine.stop = true;
+                    }
+                } else if (command == "cancel") {
+                    cancelled = true;
+                    interrupt = true;
+                    engine.stop = true;
+                }
+            }
+            {
+                std::lock_guard lock(mutex);
+                closing = true;
+                interrupt = true;
+                engine.stop = true;
+            }
+            wake.notify_one();
+            searcher.join();
+        }
+
+        struct WorkerState {
+            std::unique_ptr<LineSocket> connection;
+            int64_t job = -1;// -1 when idle
+            size_t move = 0;
+            int32_t alpha = 0;
+        };
+    }// namespace
+
+    int RunWorker(const std::string& address, uint16_t port, size_t hash_megabytes) {
+        int listener = socket(AF_INET, SOCK_STREAM, 0);
+        int enable = 1;
+        setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+        sockaddr_in local{};
+        local.sin_family = AF_INET;
+        local.sin_port = htons(port);
+        if (listener < 0 || inet_pton(AF_INET, address.c_str(), &local.sin_addr) != 1 ||
+            bind(listener, reinterpret_cast<sockaddr*>(&local), sizeof(local)) != 0 ||
+            listen(listener, 1) != 0) {
+            std::cerr << "Can not listen on " << address << ":" << port << std::endl;
+            if (listener >= 0) {
+                close(listener);
+            }
+            return 1;
+        }
+        TranspositionTable table(hash_megabytes);
+        Engine engine;
+        engine.transposition_table = &table;
+        while (true) {
+            int descriptor = accept(listener, nullptr, nullptr);
+            if (descriptor < 0) {
+                continue;
+            }
+            LineSocket connection(descriptor);
+            Serve(connection, engine);
+        }
+    }
+
+    bool DistributedSearch(const Board& board, const SearchLimits& limits,
+                           const std::vector<std::string>& workers, SearchResult& result) {
+        std::vector<WorkerState> states(workers.size());
+        for (size_t i = 0; i < workers.size(); ++i) {
+            int descriptor = Connect(workers[i]);
+            if (descriptor < 0) {
+                std::cerr << "Can not connect to " << workers[i] << std::endl;
+                return false;
+            }
+            states[i].connection = std::make_unique<LineSocket>(descriptor);
+        }
+        if (states.empty()) {
+            return false;
+        }
+
+        // The root moves in the order of Engine::GetBestMove; a position without moves has
+        // the pass as its only move.
+        std::vector<Cell> moves = board.PossibleMoves();
+        if (moves.empty()) {
+            moves.push_back(Cell{-1, -1});
+        }
+        std::vector<std::pair<int32_t, size_t>> order;
+        for (size_t i = 0; i < moves.size(); ++i) {
+            order.emplace_back(board.MakeMove(moves[i]).FinalEvaluation(), i);
+        }
+        std::stable_sort(order.begin(), order.end(), [](const auto& lhs, const auto& rhs) {
+            return lhs.first < rhs.first;
+        });
+        std::string position(FormatPosition(board).data(), POSITION_TEXT_LENGTH);
+        auto deadline = std::chrono::steady_clock::time_point::max();
+        if (limits.milliseconds > 0) {
+            deadline = std::chrono::steady_clock::now() +
+                       std::chrono::milliseconds(limits.milliseconds);
+        }
+
+        int32_t depth = limits.depth > 0 ? limits.depth : board.EmptyCount();
+        result = {moves[order.front().second], -SCORE_BOUND, depth, 0};
+        size_t next = 0;
+        size_t finished = 0;
+        size_t busy = 0;
+        int64_t next_id = 1;
+        bool stopped = false;
+        while (busy > 0 || (!stopped && next < moves.size())) {
+            // The first move alone, for a bound to search the others with.
+            for (auto& state : states) {
+                if (!stopped && state.job < 0 && next < moves.size() &&
+                    (next == 0 || finished > 0)) {
+                    state.job = next_id++;
+                    state.move = order[next++].second;
+                    state.alpha = result.score;
+                    ++busy;
+                    std::ostringstream job;
+                    job << "job " << state.job << " " << limits.depth << " " << state.alpha << " "
+                        << SCORE_BOUND << " " << moves[state.move].ToInt() << " " << position;
+                    if (!state.connection->Send(job.str())) {
+                        return false;
+                    }
+                }
+            }
+            std::vector<pollfd> descriptors;
+            for (auto& state : states) {
+                descriptors.push_back({state.connection->Descriptor(), POLLIN, 0});
+            }
+            int timeout = -1;
+            if (!stopped && deadline != std::chrono::steady_clock::time_point::max()) {
+                auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+                        deadline - std::chrono::steady_clock::now());
+                timeout = static_cast<int>(std::max<int64_t>(remaining.count(), 0));
+            }
+            int ready = poll(descriptors.data(), descriptors.size(), timeout);
+            if (ready < 0) {
+                return false;
+            }
+            if (ready == 0) {
+                stopped = true;
+                for (auto& state : states) {
+                    if (state.job >= 0) {
+                        state.connection->Send("cancel " + std::to_string(state.job));
+                    }
+                }
+                continue;
+            }
+            for (size_t i = 0; i < states.size(); ++i) {
+                WorkerState& state = states[i];
+                if (!(descriptors[i].revents & (POLLIN | POLLHUP | POLLERR))) {
+                    continue;
+                }
+                do {
+                    std::string line;
+                    if (!state.connection->ReadLine(line)) {
+                        std::cerr << "Lost connection to " << workers[i] << std::endl;
+                        return false;
+                    }
+                    std::istringstream in(line);
+                    std::string reply;
+                    int64_t id = 0;
+                    in >> reply >> id;
+                    if (id != state.job) {
+                        continue;
+                    }
+                    state.job = -1;
+                    --busy;
+                    int64_t nodes = 0;
+                    if (reply == "cancelled") {
+                        in >> nodes;
+                        result.nodes += nodes;
+                        continue;
+                    }
+                    int32_t score = 0;
+                    int32_t alpha = 0;
+                    in >> score >> alpha >> nodes;
+                    result.nodes += nodes;
+                    ++finished;
+                    // At or below the alpha it was searched with, a score is only a bound.
+                    if (score <= alpha || score <= result.score) {
+                        continue;
+                    }
+                    result.score = score;
+                    result.move = moves[state.move];
+                    for (auto& other : states) {
+                        if (other.job >= 0 && other.alpha < result.score) {
+                            other.alpha = result.score;
+                            other.connection->Send("bound " + std::to_string(other.job) + " " +
+                                                   std::to_string(other.alpha));
+                        }
+                    }
+                } while (state.connection->HasLine());
+            }
+        }
+        if (finished == 0) {
+            std::cerr << "No move was scored before the time ran out" << std::endl;
+            return false;
+        }
+        if (finished < moves.size()) {
+            result.depth = 0;
+        }
+        return true;
+    }
+
+}// namespace ReversiEngine
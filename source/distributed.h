@@ -0,0 +1,40 @@
+#pragma once
+
+#include "board.h"
+#include "engine.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ReversiEngine {
+
+    // Root-split search over worker processes connected by TCP. The coordinator hands out one
+    // root move at a time to each worker, which scores it with its own Engine and transposition
+    // table. The first move is searched alone to get a bound; the others are searched in
+    // parallel with alpha at the best score so far, and a worker is told when that bound rises.
+    //
+    // The protocol is one text line per message:
+    //   coordinator: job ID DEPTH ALPHA BETA MOVE POSITION   (depth 0 solves the endgame)
+    //                bound ID ALPHA                          (restart job ID with a higher alpha)
+    //                cancel ID
+    //   worker:      result ID SCORE ALPHA NODES             (ALPHA as searched; SCORE is exact
+    //                                                         if above it, else an upper bound)
+    //                cancelled ID NODES
+    // POSITION is the text of FormatPosition and scores are from the root mover's view.
+
+    // Serves one coordinator at a time on `port` until the process is killed. Binds to
+    // `address`, the loopback address by default since the protocol is not authenticated.
+    // Returns non-zero if the port can not be opened.
+    int RunWorker(const std::string& address, uint16_t port, size_t hash_megabytes);
+
+    // Searches `board` to limits.depth (as Engine::GetBestMove, or exactly as Engine::Solve
+    // when it is 0) on the workers, given as "host:port". When limits.milliseconds runs out the
+    // running jobs are cancelled and the result, with depth 0, only covers the moves finished
+    // by then. Fails if a worker can not be reached or drops the connection, or if no move was
+    // scored before the time ran out.
+    [[nodiscard]] bool DistributedSearch(const Board& board, const SearchLimits& limits,
+                                         const std::vector<std::string>& workers,
+                                         SearchResult& result);
+
+}// namespace ReversiEngine
@@ -1,122 +1,736 @@
 #include "engine.h"
+#include "evaluation.h"
+#include "notation.h"
+#include "playout.h"
+#include "stability.h"
+#include "timing.h"
 
 #include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
 
 namespace ReversiEngine {
 
     const int INF = 10000;
 
+    namespace {
+        // Number of nodes between two checks of the node and time limits.
+        const int32_t LIMITS_POLL_INTERVAL = 4096;
+
+        // Search buffers are indexed by the remaining depth.
+        const int32_t MAX_DEPTH = 64;
+        static_assert(MAX_DEPTH <= SearchStats::MAX_PLY);
+
+        // Below this number of empty squares the solver does not sort moves by mobility.
+        const int32_t SOLVER_SORT_EMPTIES = 7;
+
+        // Xor-ed into the hash of network evaluations in the evaluation cache. Its low bits are
+        // not zero, so a position's network value and ordering value never share a slot.
+        const uint64_t NETWORK_CACHE_KEY = 0x9E3779B97F4A7C15ULL;
+
+        // Moves the entry of `buffer` that refers to the move on `square` to the front, keeping
+        // the order of the others.
+        void MoveToFront(const std::vector<Cell>& moves,
+                         std::vector<std::pair<int32_t, int32_t>>& buffer, uint8_t square) {
+            if (square == TranspositionTable::NO_MOVE) {
+                return;
+            }
+            for (size_t i = 0; i < buffer.size(); ++i) {
+                if (moves[buffer[i].first].ToInt() == square) {
+                    std::rotate(buffer.begin(), buffer.begin() + static_cast<ptrdiff_t>(i),
+                                buffer.begin() + static_cast<ptrdiff_t>(i) + 1);
+                    return;
+                }
+            }
+        }
+    }// namespace
+
     std::pair<ReversiEngine::Cell, int32_t>
     ReversiEngine::Engine::GetBestMove(const ReversiEngine::Board& board, int32_t depth) const {
+        auto start_time = std::chrono::steady_clock::now();
+        int64_t start_nodes = nodes;
+        root_depth_ = depth;
         ++nodes;
+        SEARCH_STATS(stats.OnInteriorNode(0));
         int32_t value = -INF;
         int32_t alpha = -INF;
         int32_t beta = INF;
         Cell best_move{-1, -1};
+        if (network) {
+            network->Update(accumulators_[depth], board);
+        }
         std::vector<Cell>& possible_moves = buffers[depth];
         board.PossibleMoves(possible_moves);
+        trace_moves_[depth] = -1;
         if (possible_moves.empty()) {
+            trace_moves_[depth - 1] = -1;
             value = -SmartEvaluation(board.MakeMove({-1, -1}), depth - 1, -beta, -alpha);
-            return {best_move, value};
+        } else {
+            auto& buffer = buffers2[depth];
+            buffer.resize(possible_moves.size());
+            for (size_t i = 0; i < possible_moves.size(); ++i) {
+                buffer[i] = {i, OrderingEvaluation(board.MakeMove(possible_moves[i]))};
+            }
+            std::sort(buffer.begin(), buffer.end(), [](auto& lhs, auto& rhs) {
+                return lhs.second < rhs.second;
+            });
+            TranspositionTable::Entry entry;
+            if (transposition_table && transposition_table->Probe(board.Hash(), entry)) {
+                MoveToFront(possible_moves, buffer, entry.move);
+            }
+            for (size_t i = 0; i < possible_moves.size(); ++i) {
+                const Cell& cell = possible_moves[buffer[i].first];
+                Board new_board = board.MakeMove(cell);
+                trace_moves_[depth - 1] = static_cast<int8_t>(cell.ToInt());
+                int32_t candidate_value = -SmartEvaluation(new_board, depth - 1, -beta, -alpha);
+                if (value < candidate_value) {
+                    value = candidate_value;
+                    best_move = cell;
+                }
+                if (alpha < value) {
+                    alpha = value;
+                }
+            }
+        }
+        if (transposition_table && !stop && best_move.row >= 0) {
+            transposition_table->Store(board.Hash(), {static_cast<int16_t>(value),
+                                                      static_cast<uint8_t>(depth),
+                                                      TranspositionTable::Exact,
+                                                      static_cast<uint8_t>(best_move.ToInt())});
+        }
+        if (!stop) {
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_time;
+            stats.iterations.push_back({depth, nodes - start_nodes, elapsed.count()});
+        }
+        if (tracing_) {
+            TraceNode(depth, -INF, INF, value);
+        }
+        return {best_move, value};
+    }
+
+    std::vector<ScoredLine> Engine::GetBestMoves(const Board& board, int32_t depth, int32_t count,
+                                                 const std::vector<ScoredLine>& previous) const {
+        auto start_time = std::chrono::steady_clock::now();
+        int64_t start_nodes = nodes;
+        root_depth_ = depth;
+        ++nodes;
+        SEARCH_STATS(stats.OnInteriorNode(0));
+        if (network) {
+            network->Update(accumulators_[depth], board);
         }
+        std::vector<ScoredLine> lines;
+        std::vector<Cell>& possible_moves = buffers[depth];
+        board.PossibleMoves(possible_moves);
+        trace_moves_[depth] = -1;
+        if (possible_moves.empty()) {
+            Board new_board = board.MakeMove(Cell{-1, -1});
+            trace_moves_[depth - 1] = -1;
+            lines.push_back({Cell{-1, -1}, -SmartEvaluation(new_board, depth - 1, -INF, INF)});
+            return lines;
+        }
+        // The previous lines in their order, then the other moves by static evaluation.
         auto& buffer = buffers2[depth];
         buffer.resize(possible_moves.size());
         for (size_t i = 0; i < possible_moves.size(); ++i) {
-            buffer[i] = {i, board.MakeMove(possible_moves[i]).FinalEvaluation()};
+            auto line = std::find_if(previous.begin(), previous.end(), [&](const ScoredLine& x) {
+                return x.move == possible_moves[i];
+            });
+            buffer[i] = {i, line != previous.end()
+                                    ? static_cast<int32_t>(line - previous.begin()) - 2 * INF
+                                    : OrderingEvaluation(board.MakeMove(possible_moves[i]))};
         }
         std::sort(buffer.begin(), buffer.end(), [](auto& lhs, auto& rhs) {
             return lhs.second < rhs.second;
         });
-        for (size_t i = 0; i < possible_moves.size(); ++i) {
-            const Cell& cell = possible_moves[buffer[i].first];
-            Board new_board = board.MakeMove(cell);
-            int32_t candidate_value = -SmartEvaluation(new_board, depth - 1, -beta, -alpha);
-            if (value < candidate_value) {
-                value = candidate_value;
-                best_move = cell;
+        auto full = static_cast<size_t>(std::max(count, 1));
+        for (const auto& [index, order] : buffer) {
+            const Cell& cell = possible_moves[index];
+            // A score at or below the worst kept line is only an upper bound and not needed.
+            int32_t alpha = lines.size() == full ? lines.back().score : -INF;
+            trace_moves_[depth - 1] = static_cast<int8_t>(cell.ToInt());
+            int32_t value = -SmartEvaluation(board.MakeMove(cell), depth - 1, -INF, -alpha);
+            if (stop) {
+                break;
             }
-            if (alpha < value) {
-                alpha = value;
+            if (value > alpha) {
+                auto position = std::find_if(lines.begin(), lines.end(), [&](const ScoredLine& x) {
+                    return x.score < value;
+                });
+                lines.insert(position, {cell, value});
+                if (lines.size() > full) {
+                    lines.pop_back();
+                }
             }
         }
-        return {best_move, value};
+        if (transposition_table && !stop) {
+            const ScoredLine& best = lines.front();
+            transposition_table->Store(board.Hash(), {static_cast<int16_t>(best.score),
+                                                      static_cast<uint8_t>(depth),
+                                                      TranspositionTable::Exact,
+                                                      static_cast<uint8_t>(best.move.ToInt())});
+        }
+        if (!stop) {
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_time;
+            stats.iterations.push_back({depth, nodes - start_nodes, elapsed.count()});
+        }
+        if (tracing_ && !lines.empty()) {
+            TraceNode(depth, -INF, INF, lines.front().score);
+        }
+        return lines;
     }
 
     int32_t ReversiEngine::Engine::SmartEvaluation(const Board& board, int32_t depth, int32_t alpha,
                                                    int32_t beta) const {
+        if (depth == 1) {
+            return NearLeafSearch<1>(board, alpha, beta);
+        }
+        int32_t score = depth == 2 ? NearLeafSearch<2>(board, alpha, beta)
+                                   : SearchNode(board, depth, alpha, beta);
+        if (tracing_) {
+            TraceNode(depth, alpha, beta, score);
+        }
+        return score;
+    }
+
+    int32_t Engine::SearchNode(const Board& board, int32_t depth, int32_t alpha,
+                               int32_t beta) const {
         ++nodes;
         if (stop) {
             return -INF;
         }
+        if (--poll_countdown_ <= 0 && LimitReached()) {
+            return -INF;
+        }
         if (depth == 0) {
-            return board.FinalEvaluation();
+            SEARCH_STATS(stats.OnLeafNode(root_depth_));
+            return LeafEvaluation(board, 0);
+        }
+        if (network) {
+            network->Update(accumulators_[depth + 1], accumulators_[depth], board);
         }
+        SEARCH_STATS(stats.OnInteriorNode(root_depth_ - depth));
         int32_t value = -INF;
 
         std::vector<Cell>& possible_moves = buffers[depth];
-        board.PossibleMoves(possible_moves);
+        {
+            SCOPED_TIMER(MoveGeneration);
+            board.PossibleMoves(possible_moves);
+        }
         if (possible_moves.empty()) {
             Board new_board = board.MakeMove(Cell{-1, -1});
+            trace_moves_[depth - 1] = -1;
             return -SmartEvaluation(new_board, depth - 1, -beta, -alpha);
         }
 
-        if (depth >= 3) {
-            auto& boards = buffers3[depth];
-            boards.resize(possible_moves.size());
-            for (size_t i = 0; i < possible_moves.size(); ++i) {
-                boards[i] = board.MakeMove(possible_moves[i]);
+        uint64_t key = 0;
+        uint8_t table_move = TranspositionTable::NO_MOVE;
+        if (transposition_table) {
+            key = board.Hash();
+            TranspositionTable::Entry entry;
+            bool hit;
+            {
+                SCOPED_TIMER(TableProbe);
+                hit = transposition_table->Probe(key, entry);
             }
-            auto& buffer = buffers2[depth];
-            buffer.resize(possible_moves.size());
-            for (size_t i = 0; i < possible_moves.size(); ++i) {
-                buffer[i] = {i, boards[i].FinalEvaluation()};
-            }
-            if (buffer.size() >= 4) {
-                std::nth_element(buffer.begin(), buffer.begin() + 4, buffer.end(),
-                                 [](auto& lhs, auto& rhs) {
-                                     return lhs.second < rhs.second;
-                                 });
-                std::sort(buffer.begin(), buffer.begin() + 4, [](auto& lhs, auto& rhs) {
-                    return lhs.second < rhs.second;
-                });
+            if (hit && entry.depth >= depth &&
+                (entry.bound == TranspositionTable::Exact ||
+                 (entry.bound == TranspositionTable::Lower && entry.score >= beta) ||
+                 (entry.bound == TranspositionTable::Upper && entry.score <= alpha))) {
+                SEARCH_STATS(stats.OnTableProbe(true, true));
+                table_cutoff_ = true;
+                return entry.score;
+            }
+            SEARCH_STATS(stats.OnTableProbe(hit, false));
+            table_move = hit ? entry.move : TranspositionTable::NO_MOVE;
+        }
+        // Results of an interrupted search are not stored.
+        auto store = [&](int32_t score, TranspositionTable::Bound bound, const Cell& cell) {
+            if (transposition_table && !stop) {
+                transposition_table->Store(key, {static_cast<int16_t>(score),
+                                                 static_cast<uint8_t>(depth), bound,
+                                                 static_cast<uint8_t>(cell.ToInt())});
+            }
+        };
+        int32_t original_alpha = alpha;
+        auto& boards = buffers3[depth];
+        boards.resize(possible_moves.size());
+        for (size_t i = 0; i < possible_moves.size(); ++i) {
+            SCOPED_TIMER(MakeMove);
+            boards[i] = board.MakeMove(possible_moves[i]);
+        }
+        auto& buffer = buffers2[depth];
+        buffer.resize(possible_moves.size());
+        for (size_t i = 0; i < possible_moves.size(); ++i) {
+            SCOPED_TIMER(Evaluation);
+            buffer[i] = {i, OrderingEvaluation(boards[i])};
+        }
+        if (buffer.size() >= 4) {
+            std::nth_element(buffer.begin(), buffer.begin() + 4, buffer.end(),
+                             [](auto& lhs, auto& rhs) {
+                                 return lhs.second < rhs.second;
+                             });
+            std::sort(buffer.begin(), buffer.begin() + 4, [](auto& lhs, auto& rhs) {
+                return lhs.second < rhs.second;
+            });
+        } else {
+            std::sort(buffer.begin(), buffer.end(), [](auto& lhs, auto& rhs) {
+                return lhs.second < rhs.second;
+            });
+        }
+        MoveToFront(possible_moves, buffer, table_move);
+        size_t best = buffer.front().first;
+        for (size_t i = 0; i < possible_moves.size(); ++i) {
+            trace_moves_[depth - 1] = static_cast<int8_t>(possible_moves[buffer[i].first].ToInt());
+            int32_t candidate_value =
+                    -SmartEvaluation(boards[buffer[i].first], depth - 1, -beta, -alpha);
+            if (candidate_value >= beta) {
+                SEARCH_STATS(stats.OnCutoff(i == 0));
+                store(candidate_value, TranspositionTable::Lower,
+                      possible_moves[buffer[i].first]);
+                return candidate_value;
+            }
+            if (candidate_value > value) {
+                value = candidate_value;
+                best = buffer[i].first;
+            }
+            alpha = std::max(alpha, value);
+        }
+        store(value,
+              value <= original_alpha ? TranspositionTable::Upper : TranspositionTable::Exact,
+              possible_moves[best]);
+        return value;
+    }
+
+    template<int32_t Depth>
+    int32_t Engine::NearLeafSearch(const Board& board, int32_t alpha, int32_t beta) const {
+        ++nodes;
+        if (stop) {
+            return -INF;
+        }
+        if (--poll_countdown_ <= 0 && LimitReached()) {
+            return -INF;
+        }
+        if (network) {
+            network->Update(accumulators_[Depth + 1], accumulators_[Depth], board);
+        }
+        SEARCH_STATS(stats.OnInteriorNode(root_depth_ - Depth));
+        uint64_t own = board.OwnDiscs().to_ullong();
+        uint64_t opponent = board.OpponentDiscs().to_ullong();
+        uint64_t moves = PlayoutMoves(own, opponent);
+        if (moves == 0) {
+            if constexpr (Depth == 1) {
+                return -SmartEvaluation(board.MakeMove(Cell{-1, -1}), 0, -beta, -alpha);
             } else {
-                std::sort(buffer.begin(), buffer.end(), [](auto& lhs, auto& rhs) {
-                    return lhs.second < rhs.second;
-                });
+                return -NearLeafSearch<Depth - 1>(board.MakeMove(Cell{-1, -1}), -beta, -alpha);
             }
-            for (size_t i = 0; i < possible_moves.size(); ++i) {
-                int32_t candidate_value =
-                        -SmartEvaluation(boards[buffer[i].first], depth - 1, -beta, -alpha);
-                if (candidate_value >= beta) {
-                    return candidate_value;
+        }
+        int32_t value = -INF;
+        bool first = true;
+        if constexpr (Depth == 1) {
+            if (!network) {
+                // The evaluation is a sum of square weights, so after a move the mover's sum in
+                // the child's stage gains the weight of the move and twice that of every flip.
+                int32_t stage = EvaluationStage(std::popcount(own | opponent) + 1);
+                const auto& weights = precalced_square_weights[stage];
+                int32_t base;
+                {
+                    SCOPED_TIMER(Evaluation);
+                    base = EvaluateDiscs(own, opponent, stage);
                 }
-                value = std::max(value, candidate_value);
-                alpha = std::max(alpha, value);
+                for (; moves; moves &= moves - 1) {
+                    ++nodes;
+                    SEARCH_STATS(stats.OnLeafNode(root_depth_));
+                    auto square = std::countr_zero(moves);
+                    int32_t candidate_value = base + weights[square];
+                    for (uint64_t flips = PlayoutFlips(own, opponent, square); flips;
+                         flips &= flips - 1) {
+                        candidate_value += 2 * weights[std::countr_zero(flips)];
+                    }
+                    if (candidate_value >= beta) {
+                        SEARCH_STATS(stats.OnCutoff(first));
+                        return candidate_value;
+                    }
+                    value = std::max(value, candidate_value);
+                    alpha = std::max(alpha, value);
+                    first = false;
+                }
+                return value;
+            }
+        }
+        for (; moves; moves &= moves - 1) {
+            auto square = std::countr_zero(moves);
+            Cell cell{square >> 3, square & 7};
+            int32_t candidate_value;
+            if constexpr (Depth == 1) {
+                ++nodes;
+                SEARCH_STATS(stats.OnLeafNode(root_depth_));
+                candidate_value = -LeafEvaluation(board.MakeMoveLast(cell), 0);
+            } else {
+                candidate_value = -NearLeafSearch<Depth - 1>(board.MakeMove(cell), -beta, -alpha);
+            }
+            if (candidate_value >= beta) {
+                SEARCH_STATS(stats.OnCutoff(first));
+                return candidate_value;
             }
+            value = std::max(value, candidate_value);
+            alpha = std::max(alpha, value);
+            first = false;
+        }
+        return value;
+    }
+
+    int32_t Engine::LeafEvaluation(const Board& board, int32_t depth) const {
+        SCOPED_TIMER(Evaluation);
+        if (!network) {
+            return board.FinalEvaluation();
+        }
+        // Network values are kept apart from the ordering evaluations of the same position.
+        uint64_t hash = board.Hash() ^ NETWORK_CACHE_KEY;
+        int32_t value;
+        if (evaluation_cache_.Probe(hash, value)) {
             return value;
         }
-        if (depth == 2) {
-            for (auto cell : possible_moves) {
-                Board new_board = board.MakeMove(cell);
-                int32_t candidate_value = -SmartEvaluation(new_board, depth - 1, -beta, -alpha);
-                if (candidate_value >= beta) {
-                    return candidate_value;
+        network->Update(accumulators_[depth + 1], accumulators_[depth], board);
+        value = network->Evaluate(accumulators_[depth], board.CurrentPlayer());
+        evaluation_cache_.Store(hash, value);
+        return value;
+    }
+
+    int32_t Engine::OrderingEvaluation(const Board& board) const {
+        uint64_t hash = board.Hash();
+        int32_t value;
+        if (!evaluation_cache_.Probe(hash, value)) {
+            value = board.FinalEvaluation();
+            evaluation_cache_.Store(hash, value);
+        }
+        return value;
+    }
+
+    bool Engine::LimitReached() const {
+        poll_countdown_ = LIMITS_POLL_INTERVAL;
+        if ((node_limit_ > 0 && nodes >= node_limit_) || (interrupt_ && *interrupt_) ||
+            std::chrono::steady_clock::now() >= deadline_) {
+            stop = true;
+        }
+        return stop;
+    }
+
+    void Engine::StartLimits(const SearchLimits& limits) const {
+        stop = false;
+        nodes = 0;
+        poll_countdown_ = LIMITS_POLL_INTERVAL;
+        node_limit_ = limits.nodes;
+        interrupt_ = limits.interrupt;
+        if (interrupt_ && *interrupt_) {
+            stop = true;
+        }
+        deadline_ = std::chrono::steady_clock::time_point::max();
+        if (limits.milliseconds > 0) {
+            deadline_ = std::chrono::steady_clock::now() +
+                        std::chrono::milliseconds(limits.milliseconds);
+        }
+        stats.Reset();
+        if (network != cached_network_ || EvaluationWeightsVersion() != cached_weights_version_) {
+            evaluation_cache_.Clear();
+            cached_network_ = network;
+            cached_weights_version_ = EvaluationWeightsVersion();
+        }
+        evaluation_cache_.hits = 0;
+        evaluation_cache_.misses = 0;
+    }
+
+    void Engine::ResetLimits() const {
+        node_limit_ = 0;
+        interrupt_ = nullptr;
+        deadline_ = std::chrono::steady_clock::time_point::max();
+    }
+
+    SearchResult Engine::Search(const Board& board, const SearchLimits& limits) const {
+        StartLimits(limits);
+        SearchResult result = IterativeDeepening(board, limits, {});
+        ResetLimits();
+        return result;
+    }
+
+    SearchHandle Engine::StartSearch(const Board& board, const SearchLimits& limits,
+                                     SearchCallback callback) const {
+        // The limits start here rather than on the new thread, so a Stop right after the call
+        // is not undone.
+        StartLimits(limits);
+        std::promise<SearchResult> promise;
+        SearchHandle handle;
+        handle.engine_ = this;
+        handle.result_ = promise.get_future().share();
+        handle.thread_ = std::thread([this, board, limits, callback = std::move(callback),
+                                      promise = std::move(promise)]() mutable {
+            SearchResult result = IterativeDeepening(board, limits, callback);
+            ResetLimits();
+            promise.set_value(result);
+        });
+        return handle;
+    }
+
+    SearchResult Engine::IterativeDeepening(const Board& board, const SearchLimits& limits,
+                                            const SearchCallback& callback) const {
+        auto start_time = std::chrono::steady_clock::now();
+        BeginTrace(board);
+        SearchResult result;
+        std::vector<Cell>& possible_moves = buffers[0];
+        board.PossibleMoves(possible_moves);
+        if (!possible_moves.empty()) {
+            result.move = possible_moves.front();
+        }
+        for (int32_t depth = 1; depth <= std::min(limits.depth, MAX_DEPTH); ++depth) {
+            if (limits.multi_pv > 1) {
+                auto lines = GetBestMoves(board, depth, limits.multi_pv, result.lines);
+                if (stop) {
+                    break;
                 }
-                value = std::max(value, candidate_value);
-                alpha = std::max(alpha, value);
+                for (auto& line : lines) {
+                    line.principal_variation = PrincipalVariation(board, line.move, depth);
+                }
+                result = {lines.front().move, lines.front().score, depth, nodes, std::move(lines)};
+            } else {
+                auto [move, score] = GetBestMove(board, depth);
+                if (stop) {
+                    break;
+                }
+                result = {move, score, depth, nodes};
             }
-        } else /* depth == 1 */ {
-            for (auto cell : possible_moves) {
-                ++nodes;
-                int32_t candidate_value = -board.MakeMoveLast(cell).FinalEvaluation();
+            if (callback) {
+                std::chrono::duration<double> elapsed =
+                        std::chrono::steady_clock::now() - start_time;
+                callback({depth, result.score,
+                          PrincipalVariation(board, result.move, depth), nodes, elapsed.count(),
+                          result.lines});
+            }
+        }
+        result.nodes = nodes;
+        stats.evaluation_cache_hits = evaluation_cache_.hits;
+        stats.evaluation_cache_misses = evaluation_cache_.misses;
+        tracing_ = false;
+        return result;
+    }
+
+    void Engine::BeginTrace(const Board& board) const {
+        PackedPosition root;
+        tracing_ = trace && trace->Sample() && PackPosition(board, root);
+        if (!tracing_) {
+            return;
+        }
+        trace_search_ = SearchTracer::NextSearch();
+        table_cutoff_ = false;
+        std::array<TraceRecord, 2> records;
+        static_assert(records.size() * TraceRecord::ROOT_BYTES == sizeof(root));
+        for (size_t i = 0; i < records.size(); ++i) {
+            records[i].search = trace_search_;
+            records[i].kind = i == 0 ? TraceRecord::Search : TraceRecord::Root;
+            std::memcpy(records[i].RootBytes(), root.data() + i * TraceRecord::ROOT_BYTES,
+                        TraceRecord::ROOT_BYTES);
+        }
+        // Both or neither, so the reader never sees half a root.
+        trace->Push(records.data(), records.size());
+    }
+
+    void Engine::TraceNode(int32_t depth, int32_t alpha, int32_t beta, int32_t score) const {
+        TraceRecord record;
+        record.search = trace_search_;
+        record.ply = static_cast<uint8_t>(root_depth_ - depth);
+        record.depth = static_cast<uint8_t>(depth);
+        record.move = trace_moves_[depth];
+        record.alpha = static_cast<int16_t>(std::clamp(alpha, -INF, INF));
+        record.beta = static_cast<int16_t>(std::clamp(beta, -INF, INF));
+        record.score = static_cast<int16_t>(std::clamp(score, -INF, INF));
+        record.flags = (table_cutoff_ ? TraceRecord::TableCutoff : 0) |
+                       (stop ? TraceRecord::Stopped : 0);
+        table_cutoff_ = false;
+        trace->Push(record);
+    }
+
+    std::vector<Cell> Engine::PrincipalVariation(const Board& board, const Cell& move,
+                                                 int32_t length) const {
+        std::vector<Cell> variation;
+        if (move.row < 0) {
+            return variation;
+        }
+        variation.push_back(move);
+        Board position = board.MakeMove(move);
+        while (transposition_table && static_cast<int32_t>(variation.size()) < length) {
+            auto moves = position.PossibleMoves();
+            if (moves.empty()) {
+                if (position.GameEnded()) {
+                    break;
+                }
+                position = position.MakeMove(Cell{-1, -1});
+                continue;
+            }
+            TranspositionTable::Entry entry;
+            if (!transposition_table->Probe(position.Hash(), entry)) {
+                break;
+            }
+            auto next = std::find_if(moves.begin(), moves.end(), [&](const Cell& cell) {
+                return cell.ToInt() == entry.move;
+            });
+            if (next == moves.end()) {
+                break;
+            }
+            variation.push_back(*next);
+            position = position.MakeMove(*next);
+        }
+        return variation;
+    }
+
+    int32_t Engine::ScoreMove(const Board& board, const Cell& cell, int32_t depth) const {
+        return ScoreMove(board, cell, depth, -INF, INF);
+    }
+
+    int32_t Engine::ScoreMove(const Board& board, const Cell& cell, int32_t depth, int32_t alpha,
+                              int32_t beta, const std::atomic<bool>* interrupt) const {
+        SearchLimits limits;
+        limits.interrupt = interrupt;
+        StartLimits(limits);
+        root_depth_ = depth;
+        int32_t score = -SmartEvaluation(board.MakeMove(cell), depth - 1, -beta, -alpha);
+        ResetLimits();
+        return score;
+    }
+
+    int32_t Engine::SolveMove(const Board& board, const Cell& cell, int32_t alpha, int32_t beta,
+                              const std::atomic<bool>* interrupt) const {
+        SearchLimits limits;
+        limits.interrupt = interrupt;
+        StartLimits(limits);
+        root_depth_ = 0;
+        int32_t score = -SolveEndgame(board.MakeMove(cell), -beta, -alpha, false);
+        ResetLimits();
+        return score;
+    }
+
+    int32_t Engine::SolveEndgame(const Board& board, int32_t alpha, int32_t beta,
+                                 bool passed) const {
+        ++nodes;
+        if (stop || (--poll_countdown_ <= 0 && LimitReached())) {
+            return 0;
+        }
+        Bitset64 mask = board.PossibleMovesMask();
+        if (mask.value == 0) {
+            if (passed) {
+                return board.FinalScore();
+            }
+            return -SolveEndgame(board.MakeMove(Cell{-1, -1}), -beta, -alpha, true);
+        }
+        int32_t empties = board.EmptyCount();
+        if (empties == 1) {
+            auto position = static_cast<int32_t>(mask._Find_first());
+            return -board.MakeMoveLast(Cell{position >> 3, position & 7}).FinalScore();
+        }
+        // The opponent keeps its stable discs, which caps the score; only worth computing when
+        // the opponent has few enough discs for the cap to reach alpha.
+        uint64_t opponent = board.OpponentDiscs().to_ullong();
+        if (alpha >= 64 - 2 * std::popcount(opponent)) {
+            int32_t bound =
+                    64 - 2 * std::popcount(StableDiscs<8>(opponent, board.OwnDiscs().to_ullong()));
+            if (bound <= alpha) {
+                return bound;
+            }
+        }
+        int32_t value = -INF;
+        if (empties < SOLVER_SORT_EMPTIES) {
+            for (size_t position = mask._Find_first(); position < 64;
+                 position = mask._Find_next(position)) {
+                Cell cell{static_cast<int32_t>(position >> 3), static_cast<int32_t>(position & 7)};
+                int32_t candidate_value = -SolveEndgame(board.MakeMove(cell), -beta, -alpha, false);
                 if (candidate_value >= beta) {
                     return candidate_value;
                 }
                 value = std::max(value, candidate_value);
                 alpha = std::max(alpha, value);
             }
+            return value;
+        }
+        // Fastest-first: try the moves that leave the opponent the fewest replies first.
+        auto& boards = buffers3[empties];
+        auto& buffer = buffers2[empties];
+        boards.clear();
+        buffer.clear();
+        for (size_t position = mask._Find_first(); position < 64;
+             position = mask._Find_next(position)) {
+            Cell cell{static_cast<int32_t>(position >> 3), static_cast<int32_t>(position & 7)};
+            boards.push_back(board.MakeMove(cell));
+            buffer.emplace_back(static_cast<int32_t>(buffer.size()),
+                                std::popcount(boards.back().PossibleMovesMask().value));
+        }
+        std::sort(buffer.begin(), buffer.end(), [](auto& lhs, auto& rhs) {
+            return lhs.second < rhs.second;
+        });
+        for (const auto& [index, mobility] : buffer) {
+            int32_t candidate_value = -SolveEndgame(boards[index], -beta, -alpha, false);
+            if (candidate_value >= beta) {
+                return candidate_value;
+            }
+            value = std::max(value, candidate_value);
+            alpha = std::max(alpha, value);
         }
         return value;
     }
 
+    SearchResult Engine::Solve(const Board& board, const SearchLimits& limits) const {
+        StartLimits(limits);
+        SearchResult result;
+        int32_t alpha = -INF;
+        std::vector<Cell>& possible_moves = buffers[0];
+        board.PossibleMoves(possible_moves);
+        if (possible_moves.empty()) {
+            result.score = -SolveEndgame(board.MakeMove(Cell{-1, -1}), -INF, INF, true);
+        } else {
+            result.move = possible_moves.front();
+            result.score = -INF;
+        }
+        for (const auto& cell : possible_moves) {
+            int32_t value = -SolveEndgame(board.MakeMove(cell), -INF, -alpha, false);
+            if (stop) {
+                break;
+            }
+            if (value > result.score) {
+                result.score = value;
+                result.move = cell;
+            }
+            alpha = std::max(alpha, value);
+        }
+        result.depth = stop ? 0 : board.EmptyCount();
+        result.nodes = nodes;
+        ResetLimits();
+        return result;
+    }
+
+    SearchHandle::~SearchHandle() {
+        if (thread_.joinable()) {
+            Stop();
+            thread_.join();
+        }
+    }
+
+    void SearchHandle::Stop() {
+        if (engine_) {
+            engine_->stop = true;
+        }
+    }
+
+    bool SearchHandle::Done() const {
+        return result_.valid() &&
+               result_.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    }
+
+    SearchResult SearchHandle::Wait() {
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+        return result_.valid() ? result_.get() : SearchResult{};
+    }
+
+    std::shared_future<SearchResult> SearchHandle::Future() const {
+        return result_;
+    }
+
 }// namespace ReversiEngine
@@ -1,10 +1,96 @@
 #pragma once
 
 #include "board.h"
+#include "evaluation_cache.h"
+#include "network.h"
+#include "search_stats.h"
+#include "search_trace.h"
+#include "transposition_table.h"
 #include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <thread>
+#include <vector>
 
 namespace ReversiEngine {
 
+    struct SearchLimits {
+        int32_t depth = 32;
+        int64_t nodes = 0;       // 0 means unlimited
+        int64_t milliseconds = 0;// 0 means unlimited
+        // Number of best root moves to score exactly; more than 1 fills SearchResult::lines.
+        int32_t multi_pv = 1;
+        // Stops the search once set. Unlike Engine::stop it is not cleared when the search
+        // starts, so a request that comes just before is not lost.
+        const std::atomic<bool>* interrupt = nullptr;
+    };
+
+    // A root move with its exact score.
+    struct ScoredLine {
+        Cell move{-1, -1};
+        int32_t score = 0;
+        // `move` first; continued from the transposition table when the engine has one.
+        std::vector<Cell> principal_variation;
+    };
+
+    struct SearchResult {
+        Cell move{-1, -1};
+        int32_t score = 0;
+        int32_t depth = 0;
+        int64_t nodes = 0;
+        // The best SearchLimits::multi_pv moves, best first, when more than one was asked for.
+        std::vector<ScoredLine> lines;
+    };
+
+    // A completed iteration of iterative deepening.
+    struct SearchIteration {
+        int32_t depth = 0;
+        int32_t score = 0;
+        // Best move first; continued from the transposition table when the engine has one.
+        std::vector<Cell> principal_variation;
+        int64_t nodes = 0;
+        double seconds = 0;// since the start of the search
+        // As in SearchResult.
+        std::vector<ScoredLine> lines;
+    };
+
+    // Called on the search thread after every completed iteration; it should return quickly.
+    using SearchCallback = std::function<void(const SearchIteration&)>;
+
+    class Engine;
+
+    // A search running on its own thread, returned by Engine::StartSearch. None of its methods
+    // but Wait blocks. Destroying the handle stops the search and joins the thread.
+    class SearchHandle {
+    public:
+        SearchHandle() = default;
+
+        SearchHandle(SearchHandle&&) = default;
+
+        SearchHandle& operator=(SearchHandle&&) = delete;
+
+        ~SearchHandle();
+
+        // Asks the search to finish; it returns the last completed iteration soon after.
+        void Stop();
+
+        [[nodiscard]] bool Done() const;
+
+        // Blocks until the search has finished. An empty result for a handle without a search
+        // (default-constructed or moved from).
+        SearchResult Wait();
+
+        [[nodiscard]] std::shared_future<SearchResult> Future() const;
+
+    private:
+        friend class Engine;
+
+        const Engine* engine_ = nullptr;
+        std::shared_future<SearchResult> result_;
+        std::thread thread_;
+    };
+
     class Engine {
     public:
         Engine() {
@@ -20,18 +106,127 @@ namespace ReversiEngine {
             for (auto& now : buffers3) {
                 now.reserve(100);
             }
+            accumulators_.resize(100);
+            trace_moves_.resize(100, -1);
         }
 
         [[nodiscard]] std::pair<ReversiEngine::Cell, int32_t> GetBestMove(const Board& board,
                                                                           int32_t depth) const;
 
+        // The `count` best root moves with exact scores, best first. Each move is searched with
+        // alpha at the score of the count-th best so far, so the others only fail low. The
+        // moves of `previous` (an earlier iteration's result) are searched first.
+        [[nodiscard]] std::vector<ScoredLine>
+        GetBestMoves(const Board& board, int32_t depth, int32_t count,
+                     const std::vector<ScoredLine>& previous) const;
+
         [[nodiscard]] int32_t SmartEvaluation(const Board& board, int32_t depth, int32_t alpha,
                                               int32_t beta) const;
 
+        // Iterative deepening until one of the limits is reached. Returns the result of the last
+        // completed iteration (or the first legal move if none has completed).
+        [[nodiscard]] SearchResult Search(const Board& board, const SearchLimits& limits) const;
+
+        // Runs Search on a new thread and returns at once. The engine must not be used by
+        // anything else until the search has finished.
+        [[nodiscard]] SearchHandle StartSearch(const Board& board, const SearchLimits& limits,
+                                               SearchCallback callback = {}) const;
+
+        // `move` followed by the best moves stored in the transposition table, at most `length`
+        // moves in all.
+        [[nodiscard]] std::vector<Cell> PrincipalVariation(const Board& board, const Cell& move,
+                                                           int32_t length) const;
+
+        // Full-window score of playing `cell`, searched as deep as a root search to `depth`
+        // searches it. The depth must be at least 1.
+        [[nodiscard]] int32_t ScoreMove(const Board& board, const Cell& cell, int32_t depth) const;
+
+        // Fail-soft score of playing `cell` within the window (alpha, beta), searched as above.
+        // Meaningless if the search was stopped, by `interrupt` (see SearchLimits) or otherwise.
+        [[nodiscard]] int32_t ScoreMove(const Board& board, const Cell& cell, int32_t depth,
+                                        int32_t alpha, int32_t beta,
+                                        const std::atomic<bool>* interrupt = nullptr) const;
+
+        // Fail-soft exact score of playing `cell` within the window (alpha, beta). Meaningless if
+        // the search was stopped.
+        [[nodiscard]] int32_t SolveMove(const Board& board, const Cell& cell, int32_t alpha,
+                                        int32_t beta,
+                                        const std::atomic<bool>* interrupt = nullptr) const;
+
+        // Exact disc difference (empty squares go to the winner) with alpha-beta pruning.
+        [[nodiscard]] int32_t SolveEndgame(const Board& board, int32_t alpha, int32_t beta,
+                                           bool passed) const;
+
+        // Solves the position exactly unless the node or time limit stops the search first, in
+        // which case the returned depth is 0. Only the limits' node and time fields are used.
+        [[nodiscard]] SearchResult Solve(const Board& board, const SearchLimits& limits) const;
+
         mutable std::vector<std::vector<Cell>> buffers;
         mutable std::vector<std::vector<std::pair<std::int32_t, std::int32_t>>> buffers2;
         mutable std::vector<std::vector<Board>> buffers3;
         mutable int64_t nodes = 0;
-        std::atomic<bool> stop;
+        mutable SearchStats stats;
+        mutable std::atomic<bool> stop;
+        // Optional table shared with other engines; not owned.
+        TranspositionTable* transposition_table = nullptr;
+        // Optional network that replaces Board::FinalEvaluation at the leaves; not owned.
+        const Network* network = nullptr;
+        // Optional buffer that sampled searches record their nodes in, down to two plies above
+        // the leaves; not owned and not shared with other engines.
+        TraceBuffer* trace = nullptr;
+
+    private:
+        [[nodiscard]] bool LimitReached() const;
+
+        void StartLimits(const SearchLimits& limits) const;
+
+        void ResetLimits() const;
+
+        // Iterative deepening with the limits already started.
+        [[nodiscard]] SearchResult IterativeDeepening(const Board& board,
+                                                      const SearchLimits& limits,
+                                                      const SearchCallback& callback) const;
+
+        // SmartEvaluation apart from the two plies above the leaves and the tracing.
+        [[nodiscard]] int32_t SearchNode(const Board& board, int32_t depth, int32_t alpha,
+                                         int32_t beta) const;
+
+        // Decides whether the search from `board` is traced and if so records its root.
+        void BeginTrace(const Board& board) const;
+
+        // Records the node at `depth` that has returned `score`.
+        void TraceNode(int32_t depth, int32_t alpha, int32_t beta, int32_t score) const;
+
+        // The two plies above the leaves with the remaining depth fixed at compile time. Depth 1
+        // scores the moves from the move mask and the flipped discs without building children.
+        template<int32_t Depth>
+        [[nodiscard]] int32_t NearLeafSearch(const Board& board, int32_t alpha,
+                                             int32_t beta) const;
+
+        // Static evaluation of a leaf at `depth`, updating its network accumulator from the
+        // one of its parent at depth + 1 unless the value is cached.
+        [[nodiscard]] int32_t LeafEvaluation(const Board& board, int32_t depth) const;
+
+        // Board::FinalEvaluation through the evaluation cache, for move ordering.
+        [[nodiscard]] int32_t OrderingEvaluation(const Board& board) const;
+
+        mutable int64_t node_limit_ = 0;
+        mutable std::chrono::steady_clock::time_point deadline_ =
+                std::chrono::steady_clock::time_point::max();
+        mutable const std::atomic<bool>* interrupt_ = nullptr;
+        mutable int32_t poll_countdown_ = 0;
+        mutable int32_t root_depth_ = 0;
+        // Network accumulators of the current line, indexed by the remaining depth.
+        mutable std::vector<NetworkAccumulator> accumulators_;
+        // Kept between searches while the network and the evaluation weights stay the same.
+        mutable EvaluationCache evaluation_cache_;
+        mutable const Network* cached_network_ = nullptr;
+        mutable uint32_t cached_weights_version_ = 0;
+        mutable bool tracing_ = false;
+        mutable uint32_t trace_search_ = 0;
+        // Set by a node that returns a table score, for its trace record.
+        mutable bool table_cutoff_ = false;
+        // Squares of the moves of the current line, indexed by the remaining depth after them.
+        mutable std::vector<int8_t> trace_moves_;
     };
 }// namespace ReversiEngine
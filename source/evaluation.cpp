@@ -0,0 +1,139 @@
+#include "evaluation.h"
+#include "huge_pages.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+ReversiEngine::RowCostTable& precalced_row_costs =
+        ReversiEngine::TableArena::Instance().Create<ReversiEngine::RowCostTable>();
+
+std::array<std::array<int16_t, 64>, ReversiEngine::EvaluationWeights::STAGES>
+        precalced_square_weights;
+
+namespace ReversiEngine {
+
+    namespace {
+        // Class of the square (row, col) once folded into the a1-d1-d4 triangle.
+        // clang-format off
+        const std::array<std::array<int32_t, 4>, 4> TRIANGLE_CLASS = {{
+            {0, 1, 2, 3},
+            {1, 4, 5, 6},
+            {2, 5, 7, 8},
+            {3, 6, 8, 9}
+        }};
+        // clang-format on
+
+        std::atomic<uint32_t> weights_version{0};
+    }// namespace
+
+    int32_t SquareClass(int32_t position) {
+        int32_t row = position >> 3;
+        int32_t col = position & 7;
+        return TRIANGLE_CLASS[std::min(row, 7 - row)][std::min(col, 7 - col)];
+    }
+
+    EvaluationWeights EvaluationWeights::Default() {
+        EvaluationWeights result;
+        for (auto& stage : result.weights) {
+            stage = {100, 30, 30, 30, 1, 1, 1, 1, 1, 1};
+        }
+        return result;
+    }
+
+    int32_t EvaluationWeights::MaxEvaluation(int32_t stage) const {
+        int32_t result = 0;
+        for (int32_t position = 0; position < 64; ++position) {
+            result += std::abs(weights[stage][SquareClass(position)]);
+        }
+        return result;
+    }
+
+    bool EvaluationWeights::Load(const std::string& path) {
+        std::ifstream in(path);
+        if (!in) {
+            return false;
+        }
+        EvaluationWeights result;
+        int32_t stage = 0;
+        std::string line;
+        while (stage < STAGES && std::getline(in, line)) {
+            line = line.substr(0, line.find('#'));
+            std::istringstream values(line);
+            int32_t count = 0;
+            while (count < SQUARE_CLASSES && values >> result.weights[stage][count]) {
+                ++count;
+            }
+            if (count == 0) {
+                continue;
+            }
+            if (count != SQUARE_CLASSES || result.MaxEvaluation(stage) > MAX_EVALUATION) {
+                return false;
+            }
+            ++stage;
+        }
+        if (stage != STAGES) {
+            return false;
+        }
+        *this = result;
+        return true;
+    }
+
+    bool EvaluationWeights::Save(const std::string& path) const {
+        std::ofstream out(path);
+        out << "# Evaluation weights, one line per stage: a1 b1 c1 d1 b2 c2 d2 c3 d3 d4\n";
+        for (const auto& stage : weights) {
+            for (int32_t i = 0; i < SQUARE_CLASSES; ++i) {
+                out << (i == 0 ? "" : " ") << stage[i];
+            }
+            out << "\n";
+        }
+        return static_cast<bool>(out);
+    }
+
+    void SetEvaluationWeights(const EvaluationWeights& weights) {
+        for (int32_t stage = 0; stage < EvaluationWeights::STAGES; ++stage) {
+            for (int32_t position = 0; position < 64; ++position) {
+                precalced_square_weights[stage][position] =
+                        static_cast<int16_t>(weights.weights[stage][SquareClass(position)]);
+            }
+            for (int32_t row = 0; row < 4; ++row) {
+                for (int32_t mask_first = 0; mask_first < (1 << 8); ++mask_first) {
+                    for (int32_t mask_second = 0; mask_second < (1 << 8); ++mask_second) {
+                        if (mask_first & mask_second) {
+                            continue;
+                        }
+                        int32_t cost = 0;
+                        for (int32_t col = 0; col < 8; ++col) {
+                            int32_t weight = weights.weights[stage][SquareClass((row << 3) + col)];
+                            if ((mask_first >> col) & 1) {
+                                cost += weight;
+                            } else if ((mask_second >> col) & 1) {
+                                cost -= weight;
+                            }
+                        }
+                        precalced_row_costs[stage][row][(mask_first << 8) + mask_second] =
+                                static_cast<int16_t>(cost);
+                    }
+                }
+            }
+        }
+        ++weights_version;
+    }
+
+    uint32_t EvaluationWeightsVersion() {
+        return weights_version;
+    }
+
+    bool LoadEvaluationWeights(const std::string& path) {
+        EvaluationWeights weights;
+        if (!weights.Load(path)) {
+            return false;
+        }
+        SetEvaluationWeights(weights);
+        return true;
+    }
+
+}// namespace ReversiEngine
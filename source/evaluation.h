@@ -0,0 +1,83 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <string>
+
+namespace ReversiEngine {
+
+    // Weights of the linear evaluation: one value per square class for every game stage. The ten
+    // square classes are the squares equal under the board symmetries, in the order a1, b1, c1,
+    // d1, b2, c2, d2, c3, d3, d4.
+    struct EvaluationWeights {
+        static constexpr int32_t STAGES = 4;
+        static constexpr int32_t SQUARE_CLASSES = 10;
+        // Largest possible evaluation; it has to stay well below the search window bounds.
+        static constexpr int32_t MAX_EVALUATION = 9000;
+
+        std::array<std::array<int32_t, SQUARE_CLASSES>, STAGES> weights{};
+
+        // 100 for corners, 30 for the other edge squares and 1 for the rest, in every stage.
+        [[nodiscard]] static EvaluationWeights Default();
+
+        // Largest absolute evaluation the weights of `stage` can produce.
+        [[nodiscard]] int32_t MaxEvaluation(int32_t stage) const;
+
+        // Text file with one line of SQUARE_CLASSES integers per stage; '#' starts a comment.
+        [[nodiscard]] bool Load(const std::string& path);
+
+        [[nodiscard]] bool Save(const std::string& path) const;
+    };
+
+    [[nodiscard]] int32_t SquareClass(int32_t position);
+
+    // Stage of a position with `discs` discs on the board.
+    [[nodiscard]] constexpr int32_t EvaluationStage(int32_t discs) {
+        return (discs - 4) * EvaluationWeights::STAGES / 61;
+    }
+
+    // Rebuilds the row tables of Board::FinalEvaluation. Must not run concurrently with a search.
+    void SetEvaluationWeights(const EvaluationWeights& weights);
+
+    // Changes with every SetEvaluationWeights, so that cached evaluations can be dropped.
+    [[nodiscard]] uint32_t EvaluationWeightsVersion();
+
+    // Loads a weight file and installs it; returns false and keeps the current weights on error.
+    [[nodiscard]] bool LoadEvaluationWeights(const std::string& path);
+
+}// namespace ReversiEngine
+
+namespace ReversiEngine {
+
+    // Cost of one row for the side to move, indexed by stage, row class (rows 1 and 8, 2 and 7,
+    // 3 and 6, 4 and 5 share a class) and (own row mask << 8) + opponent row mask.
+    using RowCostTable =
+            std::array<std::array<std::array<int16_t, 1 << 16>, 4>, EvaluationWeights::STAGES>;
+
+}// namespace ReversiEngine
+
+// 2 MB in the table arena.
+extern ReversiEngine::RowCostTable& precalced_row_costs;
+
+// Weight of every square for the side to move, indexed by stage and square.
+extern std::array<std::array<int16_t, 64>, ReversiEngine::EvaluationWeights::STAGES>
+        precalced_square_weights;
+
+namespace ReversiEngine {
+
+    // Evaluation of `own` against `opponent` with the weights of `stage`. Board::FinalEvaluation
+    // is this with the stage of the position; the search also uses it with the stage of a child.
+    [[nodiscard]] inline int32_t EvaluateDiscs(uint64_t own, uint64_t opponent, int32_t stage) {
+        const auto& row_costs = precalced_row_costs[stage];
+        int32_t result = 0;
+        for (int32_t row = 0; row < 8; ++row) {
+            int shift = 8 * row;
+            auto own_mask = (own >> shift) & ((1 << 8) - 1);
+            auto opponent_mask = (opponent >> shift) & ((1 << 8) - 1);
+            result += row_costs[std::min(row, 7 - row)][(own_mask << 8) + opponent_mask];
+        }
+        return result;
+    }
+
+}// namespace ReversiEngine
@@ -0,0 +1,18 @@
+#include "evaluation_cache.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace ReversiEngine {
+
+    EvaluationCache::EvaluationCache(size_t entries)
+        : entries_(std::bit_floor(std::max(entries, MIN_ENTRIES))), mask_(entries_.size() - 1) {
+    }
+
+    void EvaluationCache::Clear() {
+        std::fill(entries_.begin(), entries_.end(), 0);
+        hits = 0;
+        misses = 0;
+    }
+
+}// namespace ReversiEngine
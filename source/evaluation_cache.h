@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ReversiEngine {
+
+    // Direct-mapped cache of static evaluations for one engine, and so for one thread. An
+    // entry is a single word: the position hash with its low 16 bits replaced by the
+    // evaluation. The slot index comes from the low bits of the hash, so with at least 2^16
+    // slots the whole hash is checked. A colliding position overwrites the slot.
+    class EvaluationCache {
+    public:
+        // Rounded down to a power of two, and up to 2^16 so that no hash bits go unchecked.
+        explicit EvaluationCache(size_t entries = MIN_ENTRIES);
+
+        [[nodiscard]] bool Probe(uint64_t hash, int32_t& value) {
+            uint64_t entry = entries_[hash & mask_];
+            if (((entry ^ hash) & KEY_MASK) != 0 || entry == 0) {
+                ++misses;
+                return false;
+            }
+            ++hits;
+            value = static_cast<int16_t>(entry & ~KEY_MASK);
+            return true;
+        }
+
+        void Store(uint64_t hash, int32_t value) {
+            entries_[hash & mask_] = (hash & KEY_MASK) | static_cast<uint16_t>(value);
+        }
+
+        void Clear();
+
+        int64_t hits = 0;
+        int64_t misses = 0;
+
+    private:
+        static constexpr size_t MIN_ENTRIES = 1 << 16;
+        static constexpr uint64_t KEY_MASK = ~uint64_t{0xFFFF};
+
+        std::vector<uint64_t> entries_;
+        uint64_t mask_;
+    };
+
+}// namespace ReversiEngine
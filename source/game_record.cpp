@@ -0,0 +1,362 @@
+#include "game_record.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <iterator>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
+
+namespace ReversiEngine {
+
+    namespace {
+        const char ARCHIVE_MAGIC[4] = {'R', 'V', 'G', '2'};
+        const char INDEX_MAGIC[4] = {'R', 'V', 'G', 'I'};
+        // Index entry: block offset (8 bytes), games (4) and size in bytes (4).
+        constexpr size_t INDEX_ENTRY_SIZE = 16;
+        // Trailer: index offset (8 bytes), block count (4) and INDEX_MAGIC.
+        constexpr size_t TRAILER_SIZE = 16;
+
+        void PutInteger(std::vector<uint8_t>& out, uint64_t value, int32_t bytes) {
+            for (int32_t i = 0; i < bytes; ++i) {
+                out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+            }
+        }
+
+        uint64_t GetInteger(const uint8_t* data, int32_t bytes) {
+            uint64_t value = 0;
+            for (int32_t i = 0; i < bytes; ++i) {
+                value |= static_cast<uint64_t>(data[i]) << (8 * i);
+            }
+            return value;
+        }
+
+        class BitWriter {
+        public:
+            explicit BitWriter(std::vector<uint8_t>& out) : out_(out) {
+            }
+
+            void Put(uint32_t value, int32_t bits) {
+                buffer_ |= value << count_;
+                count_ += bits;
+                while (count_ >= 8) {
+                    out_.push_back(static_cast<uint8_t>(buffer_));
+                    buffer_ >>= 8;
+                    count_ -= 8;
+                }
+            }
+
+            void Flush() {
+                if (count_ > 0) {
+                    out_.push_back(static_cast<uint8_t>(buffer_));
+                }
+                buffer_ = 0;
+                count_ = 0;
+            }
+
+        private:
+            std::vector<uint8_t>& out_;
+            uint32_t buffer_ = 0;
+            int32_t count_ = 0;
+        };
+
+        // Reads bytes only when their bits are needed, so after the last value of a game the
+        // cursor is at the first byte of the next game.
+        class BitReader {
+        public:
+            BitReader(const uint8_t*& cursor, const uint8_t* end) : cursor_(cursor), end_(end) {
+            }
+
+            bool Get(int32_t bits, uint32_t& value) {
+                while (count_ < bits) {
+                    if (cursor_ == end_) {
+                        return false;
+                    }
+                    buffer_ |= static_cast<uint32_t>(*cursor_++) << count_;
+                    count_ += 8;
+                }
+                value = buffer_ & ((1u << bits) - 1);
+                buffer_ >>= bits;
+                count_ -= bits;
+                return true;
+            }
+
+        private:
+            const uint8_t*& cursor_;
+            const uint8_t* end_;
+            uint32_t buffer_ = 0;
+            int32_t count_ = 0;
+        };
+
+        // Bits needed for the index of a move among `moves`.
+        int32_t MoveBits(uint64_t moves) {
+            return std::bit_width(static_cast<uint64_t>(std::popcount(moves) - 1));
+        }
+
+        // Square of the `index`-th legal move.
+        int32_t NthSquare(uint64_t moves, uint32_t index) {
+#ifdef __BMI2__
+            return std::countr_zero(_pdep_u64(uint64_t{1} << index, moves));
+#else
+            for (uint32_t i = 0; i < index; ++i) {
+                moves &= moves - 1;
+            }
+            return std::countr_zero(moves);
+#endif
+        }
+
+        uint64_t LegalMoves(Board& board) {
+            uint64_t moves = board.PossibleMovesMask().to_ullong();
+            if (moves == 0) {
+                board = board.MakeMove(Cell{-1, -1});
+                moves = board.PossibleMovesMask().to_ullong();
+            }
+            return moves;
+        }
+
+        bool EncodeGame(const GameRecord& record, std::vector<uint8_t>& out) {
+            if (record.length > record.squares.size()) {
+                return false;
+            }
+            out.push_back(record.length);
+            out.push_back(static_cast<uint8_t>(record.result));
+            BitWriter bits(out);
+            Board board;
+            for (size_t i = 0; i < record.length; ++i) {
+                uint64_t moves = LegalMoves(board);
+                uint64_t square = uint64_t{1} << (record.squares[i] & 63);
+                if (record.squares[i] >= 64 || (moves & square) == 0) {
+                    return false;
+                }
+                bits.Put(std::popcount(moves & (square - 1)), MoveBits(moves));
+                board = board.MakeMove(record.Move(i));
+            }
+            bits.Flush();
+            return true;
+        }
+
+        bool DecodeGame(const uint8_t*& cursor, const uint8_t* end, GameRecord& record,
+                        std::vector<Board>* positions) {
+            if (end - cursor < 2) {
+                return false;
+            }
+            record = GameRecord{};
+            record.length = *cursor++;
+            record.result = static_cast<int8_t>(*cursor++);
+            if (record.length > record.squares.size()) {
+                return false;
+            }
+            if (positions) {
+                positions->clear();
+            }
+            BitReader bits(cursor, end);
+            Board board;
+            for (size_t i = 0; i < record.length; ++i) {
+                uint64_t moves = LegalMoves(board);
+                uint32_t index = 0;
+                if (moves == 0 || !bits.Get(MoveBits(moves), index) ||
+                    index >= static_cast<uint32_t>(std::popcount(moves))) {
+                    return false;
+                }
+                if (positions) {
+                    positions->push_back(board);
+                }
+                record.squares[i] = static_cast<uint8_t>(NthSquare(moves, index));
+                board = board.MakeMove(record.Move(i));
+            }
+            if (positions) {
+                positions->push_back(board);
+            }
+            return true;
+        }
+    }// namespace
+
+    bool ReplayMove(Board& board, const Cell& cell) {
+        auto moves = board.PossibleMoves();
+        if (moves.empty()) {
+            board = board.MakeMove(Cell{-1, -1});
+            moves = board.PossibleMoves();
+        }
+        if (std::find(moves.begin(), moves.end(), cell) == moves.end()) {
+            return false;
+        }
+        board = board.MakeMove(cell);
+        return true;
+    }
+
+    GameWriter::GameWriter(const std::string& path) : out_(path, std::ios::binary) {
+        out_.write(ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC));
+        offset_ = sizeof(ARCHIVE_MAGIC);
+    }
+
+    GameWriter::~GameWriter() {
+        static_cast<void>(Close());
+    }
+
+    bool GameWriter::IsOpen() const {
+        return !failed_ && out_.good();
+    }
+
+    void GameWriter::Write(const GameRecord& record) {
+        size_t size = block_.size();
+        if (closed_ || !EncodeGame(record, block_)) {
+            block_.resize(size);
+            failed_ = true;
+            return;
+        }
+        if (++block_games_ == BLOCK_GAMES) {
+            FlushBlock();
+        }
+    }
+
+    void GameWriter::FlushBlock() {
+        if (block_games_ == 0) {
+            return;
+        }
+        out_.write(reinterpret_cast<const char*>(block_.data()),
+                   static_cast<std::streamsize>(block_.size()));
+        index_.push_back({offset_, block_games_, static_cast<uint32_t>(block_.size())});
+        offset_ += block_.size();
+        block_.clear();
+        block_games_ = 0;
+    }
+
+    bool GameWriter::Close() {
+        if (closed_) {
+            return IsOpen();
+        }
+        FlushBlock();
+        closed_ = true;
+        std::vector<uint8_t> index;
+        for (const auto& block : index_) {
+            PutInteger(index, block.offset, 8);
+            PutInteger(index, block.games, 4);
+            PutInteger(index, block.bytes, 4);
+        }
+        PutInteger(index, offset_, 8);
+        PutInteger(index, index_.size(), 4);
+        index.insert(index.end(), std::begin(INDEX_MAGIC), std::end(INDEX_MAGIC));
+        out_.write(reinterpret_cast<const char*>(index.data()),
+                   static_cast<std::streamsize>(index.size()));
+        out_.flush();
+        return IsOpen();
+    }
+
+    GameReader::GameReader(const std::string& path) {
+#if defined(__unix__) || defined(__APPLE__)
+        int descriptor = open(path.c_str(), O_RDONLY);
+        if (descriptor >= 0) {
+            struct stat status {};
+            if (fstat(descriptor, &status) == 0 && status.st_size > 0) {
+                size_t size = static_cast<size_t>(status.st_size);
+                void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+                if (data != MAP_FAILED) {
+                    madvise(data, size, MADV_SEQUENTIAL);
+                    data_ = static_cast<const uint8_t*>(data);
+                    size_ = size;
+                    mapped_ = true;
+                }
+            }
+            close(descriptor);
+        }
+#endif
+        if (!mapped_) {
+            std::ifstream in(path, std::ios::binary);
+            buffer_.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+            data_ = buffer_.data();
+            size_ = buffer_.size();
+        }
+        if (size_ < sizeof(ARCHIVE_MAGIC) + TRAILER_SIZE ||
+            std::memcmp(data_, ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC)) != 0 ||
+            std::memcmp(data_ + size_ - sizeof(INDEX_MAGIC), INDEX_MAGIC, sizeof(INDEX_MAGIC)) !=
+                    0) {
+            return;
+        }
+        const uint8_t* trailer = data_ + size_ - TRAILER_SIZE;
+        uint64_t index_offset = GetInteger(trailer, 8);
+        uint64_t block_count = GetInteger(trailer + 8, 4);
+        if (index_offset + block_count * INDEX_ENTRY_SIZE != size_ - TRAILER_SIZE) {
+            return;
+        }
+        std::vector<Block> blocks;
+        for (uint64_t i = 0; i < block_count; ++i) {
+            const uint8_t* entry = data_ + index_offset + i * INDEX_ENTRY_SIZE;
+            uint64_t offset = GetInteger(entry, 8);
+            uint64_t bytes = GetInteger(entry + 12, 4);
+            if (offset < sizeof(ARCHIVE_MAGIC) || offset + bytes > index_offset) {
+                return;
+            }
+            blocks.push_back({data_ + offset, data_ + offset + bytes,
+                              static_cast<uint32_t>(GetInteger(entry + 8, 4))});
+            games_ += blocks.back().games;
+        }
+        blocks_ = std::move(blocks);
+        valid_ = true;
+    }
+
+    GameReader::~GameReader() {
+#if defined(__unix__) || defined(__APPLE__)
+        if (mapped_) {
+            munmap(const_cast<uint8_t*>(data_), size_);
+        }
+#endif
+    }
+
+    bool GameReader::IsOpen() const {
+        return valid_;
+    }
+
+    size_t GameReader::BlockCount() const {
+        return blocks_.size();
+    }
+
+    uint64_t GameReader::GameCount() const {
+        return games_;
+    }
+
+    bool GameReader::ReadBlock(size_t block, std::vector<GameRecord>& records) const {
+        records.clear();
+        if (block >= blocks_.size()) {
+            return false;
+        }
+        const uint8_t* cursor = blocks_[block].begin;
+        records.resize(blocks_[block].games);
+        for (auto& record : records) {
+            if (!DecodeGame(cursor, blocks_[block].end, record, nullptr)) {
+                records.clear();
+                return false;
+            }
+        }
+        return cursor == blocks_[block].end;
+    }
+
+    bool GameReader::Next(GameRecord& record) {
+        return NextGame(record, nullptr);
+    }
+
+    bool GameReader::Next(GameRecord& record, std::vector<Board>& positions) {
+        return NextGame(record, &positions);
+    }
+
+    bool GameReader::NextGame(GameRecord& record, std::vector<Board>* positions) {
+        while (cursor_ == block_end_) {
+            if (next_block_ == blocks_.size()) {
+                return false;
+            }
+            cursor_ = blocks_[next_block_].begin;
+            block_end_ = blocks_[next_block_].end;
+            ++next_block_;
+        }
+        return DecodeGame(cursor_, block_end_, record, positions);
+    }
+
+}// namespace ReversiEngine
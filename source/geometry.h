@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+
+namespace ReversiEngine {
+
+    // Geometry of a Size x Size board fixed at compile time. Square (row, col) is bit
+    // row * Size + col, so every size up to 8 fits in one 64-bit mask. Moves and flips are
+    // computed with shifts on the masks of the side to move (own) and its opponent.
+    template<int32_t Size>
+    struct Geometry {
+        static_assert(Size >= 4 && Size <= 8 && Size % 2 == 0);
+
+        static constexpr int32_t SQUARES = Size * Size;
+        static constexpr uint64_t ALL =
+                SQUARES == 64 ? ~uint64_t{0} : (uint64_t{1} << SQUARES) - 1;
+
+        [[nodiscard]] static constexpr int32_t Square(int32_t row, int32_t col) {
+            return row * Size + col;
+        }
+
+        [[nodiscard]] static constexpr uint64_t Bit(int32_t row, int32_t col) {
+            return uint64_t{1} << Square(row, col);
+        }
+
+        // Squares off the first and last columns. Opponent discs there can not be flanked in a
+        // direction with a horizontal component, and masking them keeps shifts from wrapping.
+        static constexpr uint64_t INNER_COLUMNS = [] {
+            uint64_t mask = 0;
+            for (int32_t row = 0; row < Size; ++row) {
+                for (int32_t col = 1; col + 1 < Size; ++col) {
+                    mask |= Bit(row, col);
+                }
+            }
+            return mask;
+        }();
+
+        // The centre discs of the first (x) and second (o) player in the initial position.
+        static constexpr uint64_t INITIAL_FIRST =
+                Bit(Size / 2, Size / 2 - 1) | Bit(Size / 2 - 1, Size / 2);
+        static constexpr uint64_t INITIAL_SECOND =
+                Bit(Size / 2 - 1, Size / 2 - 1) | Bit(Size / 2, Size / 2);
+
+        [[nodiscard]] static uint64_t Moves(uint64_t own, uint64_t opponent) {
+            uint64_t inner = opponent & INNER_COLUMNS;
+            uint64_t moves = Step<1>(Run<1>(own, inner)) | Step<-1>(Run<-1>(own, inner)) |
+                             Step<Size>(Run<Size>(own, opponent)) |
+                             Step<-Size>(Run<-Size>(own, opponent)) |
+                             Step<Size + 1>(Run<Size + 1>(own, inner)) |
+                             Step<-Size - 1>(Run<-Size - 1>(own, inner)) |
+                             Step<Size - 1>(Run<Size - 1>(own, inner)) |
+                             Step<1 - Size>(Run<1 - Size>(own, inner));
+            return moves & ALL & ~(own | opponent);
+        }
+
+        // Discs flipped by the side to move playing on `square`.
+        [[nodiscard]] static uint64_t Flips(uint64_t own, uint64_t opponent, int32_t square) {
+            uint64_t move = uint64_t{1} << square;
+            uint64_t inner = opponent & INNER_COLUMNS;
+            return Flanked<1>(own, inner, move) | Flanked<-1>(own, inner, move) |
+                   Flanked<Size>(own, opponent, move) | Flanked<-Size>(own, opponent, move) |
+                   Flanked<Size + 1>(own, inner, move) | Flanked<-Size - 1>(own, inner, move) |
+                   Flanked<Size - 1>(own, inner, move) | Flanked<1 - Size>(own, inner, move);
+        }
+
+    private:
+        template<int32_t Shift>
+        static uint64_t Step(uint64_t bits) {
+            if constexpr (Shift > 0) {
+                return bits << Shift;
+            } else {
+                return bits >> -Shift;
+            }
+        }
+
+        // Opponent discs in a line starting next to `from`, up to Size - 2 long: two single
+        // steps, then double steps over pairs of opponent discs.
+        template<int32_t Shift>
+        static uint64_t Run(uint64_t from, uint64_t opponent) {
+            uint64_t run = opponent & Step<Shift>(from);
+            run |= opponent & Step<Shift>(run);
+            if constexpr (Size > 4) {
+                uint64_t pairs = opponent & Step<Shift>(opponent);
+                run |= pairs & Step<2 * Shift>(run);
+                if constexpr (Size > 6) {
+                    run |= pairs & Step<2 * Shift>(run);
+                }
+            }
+            return run;
+        }
+
+        template<int32_t Shift>
+        static uint64_t Flanked(uint64_t own, uint64_t opponent, uint64_t move) {
+            uint64_t run = Run<Shift>(move, opponent);
+            return Step<Shift>(run) & own ? run : 0;
+        }
+    };
+
+}// namespace ReversiEngine
@@ -0,0 +1,177 @@
+#include "huge_pages.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace ReversiEngine {
+
+    namespace {
+        const size_t HUGE_PAGE_SIZE = size_t{1} << 21;
+
+        // Size of the arena blocks; the Board and evaluation tables take about 2.6 MB.
+        const size_t ARENA_BLOCK_SIZE = 2 * HUGE_PAGE_SIZE;
+
+        bool HugePagesAllowed() {
+            const char* setting = std::getenv("REVERSI_HUGE_PAGES");
+            return !setting || std::strcmp(setting, "0") != 0;
+        }
+
+#ifdef __linux__
+        // Maps `bytes` (a multiple of the huge page size) at a huge page boundary, which
+        // transparent huge pages need.
+        void* MapAligned(size_t bytes) {
+            size_t reserved = bytes + HUGE_PAGE_SIZE;
+            void* memory = mmap(nullptr, reserved, PROT_READ | PROT_WRITE,
+                                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (memory == MAP_FAILED) {
+                return nullptr;
+            }
+            auto start = reinterpret_cast<uintptr_t>(memory);
+            uintptr_t aligned = (start + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+            if (aligned > start) {
+                munmap(memory, aligned - start);
+            }
+            size_t tail = start + reserved - (aligned + bytes);
+            if (tail > 0) {
+                munmap(reinterpret_cast<void*>(aligned + bytes), tail);
+            }
+            return reinterpret_cast<void*>(aligned);
+        }
+#endif
+    }// namespace
+
+    HugePageBlock::HugePageBlock(size_t bytes) {
+        bytes = std::max<size_t>(bytes, 1);
+#ifdef __linux__
+        size_t rounded = (bytes + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+        bool huge = HugePagesAllowed();
+        if (huge) {
+            void* memory = mmap(nullptr, rounded, PROT_READ | PROT_WRITE,
+                                MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_POPULATE, -1, 0);
+            if (memory != MAP_FAILED) {
+                data_ = memory;
+                size_ = rounded;
+                backing_ = Explicit;
+                return;
+            }
+        }
+        data_ = huge ? MapAligned(rounded) : nullptr;
+        if (data_) {
+            size_ = rounded;
+            // Without THP the advice fails and the block keeps normal pages.
+            backing_ = madvise(data_, size_, MADV_HUGEPAGE) == 0 ? Transparent : Normal;
+        } else {
+            data_ = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+                         -1, 0);
+            if (data_ == MAP_FAILED) {
+                data_ = nullptr;
+                throw std::bad_alloc();
+            }
+            size_ = bytes;
+            backing_ = Normal;
+        }
+        // Touch every page now; MAP_POPULATE would fault the pages in before the advice.
+        auto page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        auto* bytes_data = static_cast<volatile char*>(data_);
+        for (size_t offset = 0; offset < size_; offset += page_size) {
+            bytes_data[offset] = 0;
+        }
+#else
+        size_ = (bytes + 63) & ~size_t{63};
+        data_ = std::aligned_alloc(64, size_);
+        if (!data_) {
+            throw std::bad_alloc();
+        }
+        std::memset(data_, 0, size_);
+        backing_ = Normal;
+#endif
+    }
+
+    HugePageBlock::~HugePageBlock() {
+        Release();
+    }
+
+    HugePageBlock::HugePageBlock(HugePageBlock&& other) noexcept
+        : data_(other.data_), size_(other.size_), backing_(other.backing_) {
+        other.data_ = nullptr;
+        other.size_ = 0;
+        other.backing_ = None;
+    }
+
+    HugePageBlock& HugePageBlock::operator=(HugePageBlock&& other) noexcept {
+        if (this != &other) {
+            Release();
+            std::swap(data_, other.data_);
+            std::swap(size_, other.size_);
+            std::swap(backing_, other.backing_);
+        }
+        return *this;
+    }
+
+    void* HugePageBlock::Data() const {
+        return data_;
+    }
+
+    size_t HugePageBlock::Size() const {
+        return size_;
+    }
+
+    HugePageBlock::Backing HugePageBlock::GetBacking() const {
+        return backing_;
+    }
+
+    void HugePageBlock::Release() {
+        if (!data_) {
+            return;
+        }
+#ifdef __linux__
+        munmap(data_, size_);
+#else
+        std::free(data_);
+#endif
+        data_ = nullptr;
+        size_ = 0;
+        backing_ = None;
+    }
+
+    const char* BackingName(HugePageBlock::Backing backing) {
+        switch (backing) {
+            case HugePageBlock::Normal:
+                return "normal pages";
+            case HugePageBlock::Transparent:
+                return "transparent huge pages";
+            case HugePageBlock::Explicit:
+                return "explicit huge pages";
+            default:
+                return "none";
+        }
+    }
+
+    TableArena& TableArena::Instance() {
+        static TableArena arena;
+        return arena;
+    }
+
+    void* TableArena::Allocate(size_t bytes, size_t alignment) {
+        std::lock_guard lock(mutex_);
+        size_t offset = (used_ + alignment - 1) & ~(alignment - 1);
+        if (blocks_.empty() || offset + bytes > blocks_.back().Size()) {
+            blocks_.emplace_back(std::max(bytes, ARENA_BLOCK_SIZE));
+            offset = 0;
+        }
+        used_ = offset + bytes;
+        return static_cast<char*>(blocks_.back().Data()) + offset;
+    }
+
+    HugePageBlock::Backing TableArena::GetBacking() {
+        std::lock_guard lock(mutex_);
+        return blocks_.empty() ? HugePageBlock::None : blocks_.front().GetBacking();
+    }
+
+}// namespace ReversiEngine
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+namespace ReversiEngine {
+
+    // Zeroed memory for a large random-access table, backed by explicit huge pages
+    // (MAP_HUGETLB) if enough are reserved, else by transparent huge pages, else by normal
+    // pages. The pages are faulted in when the block is created, so that the search does not
+    // take the page faults. REVERSI_HUGE_PAGES=0 in the environment forces normal pages.
+    class HugePageBlock {
+    public:
+        enum Backing : uint8_t { None, Normal, Transparent, Explicit };
+
+        HugePageBlock() = default;
+
+        explicit HugePageBlock(size_t bytes);
+
+        ~HugePageBlock();
+
+        HugePageBlock(HugePageBlock&& other) noexcept;
+
+        HugePageBlock& operator=(HugePageBlock&& other) noexcept;
+
+        [[nodiscard]] void* Data() const;
+
+        [[nodiscard]] size_t Size() const;
+
+        [[nodiscard]] Backing GetBacking() const;
+
+    private:
+        void Release();
+
+        void* data_ = nullptr;
+        size_t size_ = 0;
+        Backing backing_ = None;
+    };
+
+    [[nodiscard]] const char* BackingName(HugePageBlock::Backing backing);
+
+    // Bump allocator over huge page blocks for the lookup tables that live as long as the
+    // process, such as the move and evaluation tables of Board.
+    class TableArena {
+    public:
+        [[nodiscard]] static TableArena& Instance();
+
+        [[nodiscard]] void* Allocate(size_t bytes, size_t alignment);
+
+        // A value-initialized T that is never destroyed.
+        template<typename T>
+        [[nodiscard]] T& Create() {
+            static_assert(std::is_trivially_destructible_v<T>);
+            return *new (Allocate(sizeof(T), alignof(T))) T();
+        }
+
+        // Backing of the first block.
+        [[nodiscard]] HugePageBlock::Backing GetBacking();
+
+    private:
+        TableArena() = default;
+
+        std::mutex mutex_;
+        std::vector<HugePageBlock> blocks_;
+        size_t used_ = 0;// in the last block
+    };
+
+}// namespace ReversiEngine
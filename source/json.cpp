@@ -0,0 +1,17 @@
+#include "json.h"
+
+namespace ReversiEngine {
+
+    std::string JsonField(const std::string& line, const std::string& key) {
+        auto start = line.find("\"" + key + "\": ");
+        if (start == std::string::npos) {
+            return "";
+        }
+        start += key.size() + 4;
+        if (start < line.size() && line[start] == '"') {
+            return line.substr(start + 1, line.find('"', start + 1) - start - 1);
+        }
+        return line.substr(start, line.find_first_of(",}", start) - start);
+    }
+
+}// namespace ReversiEngine
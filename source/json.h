@@ -0,0 +1,11 @@
+#pragma once
+
+#include <string>
+
+namespace ReversiEngine {
+
+    // Value of `key` in a flat JSON object written on a single line (as the tools emit them),
+    // without quotes for strings. Returns an empty string if the key is missing.
+    [[nodiscard]] std::string JsonField(const std::string& line, const std::string& key);
+
+}// namespace ReversiEngine
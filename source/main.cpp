@@ -1,13 +1,43 @@
+#include "arguments.h"
 #include "board.h"
 #include "engine.h"
+#include "evaluation.h"
+#include "mcts.h"
+#include "network.h"
+#include "notation.h"
+#include "perf_counters.h"
+#include "search_trace.h"
 #include "time_wrapper.h"
+#include "timing.h"
 
-#include <atomic>
+#include <algorithm>
+#include <chrono>
 #include <iostream>
-#include <thread>
+#include <memory>
+#include <optional>
+#include <random>
 
 namespace ReversiEngine {
 
+    struct GameOptions {
+        // Print the statistics of every engine search as JSON.
+        bool print_stats = false;
+        // Report hardware performance counters of the search thread next to nodes/sec.
+        bool perf = false;
+        // Evaluation weight file written by reversi-train; the built-in weights if empty.
+        std::string weights;
+        // Network weight file; the search evaluates leaves with the network if it is set.
+        std::string network;
+        // Starting position in the text format of ParsePosition; the initial position if empty.
+        std::string position;
+        // Search with Monte Carlo tree search instead of alpha-beta.
+        bool mcts = false;
+        MctsSettings mcts_settings;
+        // File that the engine's searches are traced to, a `trace_rate` fraction of them.
+        std::string trace;
+        double trace_rate = 1;
+    };
+
     namespace {
         void ReadAndDoMove(Board& board) {
             while (true) {
@@ -48,50 +78,102 @@ namespace ReversiEngine {
         }
     }// namespace
 
-    Cell BestMoveForSecond(Board board) {
-        Time total_time(0);
-        int32_t depth = 2;
-        std::atomic<Cell> result{};
+    Cell BestMoveForSecond(Board board, const GameOptions& options, const Network* network,
+                           TraceBuffer* trace) {
+        if (options.mcts) {
+            MctsEngine engine(options.mcts_settings);
+            SearchLimits limits;
+            limits.milliseconds = 1000;
+            SearchResult result = engine.Search(board, limits);
+            std::cout << "[mcts, depth=" << result.depth << ", win=" << result.score << "]: "
+                      << result.move << " (" << result.nodes << " playouts)" << std::endl;
+            return result.move;
+        }
         Engine engine;
-        auto foo = [&]() {
-            while (depth < 32) {
-                ++depth;
-                auto [best_move_info, time] =
-                        MeasureMethod(engine, &Engine::GetBestMove, board, depth);
-                if (engine.stop) {
-                    break;
-                }
-                result = best_move_info.first;
-                int32_t evaluation = best_move_info.second;
-                total_time += time;
-                auto nodes_per_sec = static_cast<int64_t>(static_cast<double>(engine.nodes) /
-                                                          total_time.seconds);
-                std::cout << "[depth=" << depth << ", eval=" << evaluation << "]"
-                          << ": " << result << " (" << total_time << ", " << engine.nodes
-                          << " nodes, " << nodes_per_sec << " nodes/sec"
-                          << ")" << std::endl;
+        engine.network = network;
+        engine.trace = trace;
+        // Performance counters count the thread that opens them, so they are opened by the
+        // first report, on the search thread; the counts start after the first iteration.
+        std::optional<PerfCounters> counters;
+        SearchIteration counted_from;
+        auto report = [&](const SearchIteration& iteration) {
+            auto nodes_per_sec = static_cast<int64_t>(static_cast<double>(iteration.nodes) /
+                                                      std::max(iteration.seconds, 1e-9));
+            std::cout << "[depth=" << iteration.depth << ", eval=" << iteration.score << "]:";
+            if (iteration.principal_variation.empty()) {
+                std::cout << " " << Cell{-1, -1};
+            }
+            for (const auto& cell : iteration.principal_variation) {
+                std::cout << " " << cell;
+            }
+            std::cout << " (" << Time(std::chrono::duration<double>(iteration.seconds)) << ", "
+                      << iteration.nodes << " nodes, " << nodes_per_sec << " nodes/sec"
+                      << ")" << std::endl;
+            if (!options.perf) {
+                return;
+            }
+            if (counters) {
+                std::cout << "    "
+                          << counters->Read().Format(iteration.nodes - counted_from.nodes,
+                                                     iteration.seconds - counted_from.seconds)
+                          << std::endl;
+            } else {
+                counters.emplace();
+                counters->Start();
+                counted_from = iteration;
             }
         };
-        std::jthread th(foo);
-        sleep(1);
-        engine.stop = true;
-        return result;
+        SearchLimits limits;
+        limits.milliseconds = 1000;
+        SearchResult result = engine.StartSearch(board, limits, report).Wait();
+        if (options.print_stats) {
+            // Empty unless built with SCOPED_TIMERS; the totals are over the whole game.
+            std::cout << engine.stats.ToJson() << "\n"
+                      << FormatTimings(CollectTimings()) << std::flush;
+        }
+        return result.move;
     }
 
-    void StartGame(Player player) {
+    void StartGame(Player player, const GameOptions& options) {
         Board board;
         board.InitPrecalc();
-        if (player == First) {
+        if (!options.weights.empty() && !LoadEvaluationWeights(options.weights)) {
+            std::cerr << "Can not load evaluation weights from " << options.weights << std::endl;
+            return;
+        }
+        std::unique_ptr<Network> network;
+        if (!options.network.empty()) {
+            network = std::make_unique<Network>();
+            if (!network->Load(options.network)) {
+                std::cerr << "Can not load network from " << options.network << std::endl;
+                return;
+            }
+        }
+        if (!options.position.empty() && !ParsePosition(options.position, board)) {
+            std::cerr << "Can not parse position " << options.position << std::endl;
+            return;
+        }
+        std::unique_ptr<SearchTracer> tracer;
+        TraceBuffer* trace = nullptr;
+        if (!options.trace.empty()) {
+            tracer = std::make_unique<SearchTracer>(options.trace, options.trace_rate);
+            if (!tracer->IsOpen()) {
+                std::cerr << "Can not open trace file " << options.trace << std::endl;
+                return;
+            }
+            trace = tracer->CreateBuffer();
+        }
+        if (board.CurrentPlayer() == player) {
             std::cout << board << std::endl;
             ReadAndDoMove(board);
         }
         while (!board.GameEnded()) {
-            board = board.MakeMove(BestMoveForSecond(board));
+            board = board.MakeMove(BestMoveForSecond(board, options, network.get(), trace));
             std::cout << board << std::endl;
             ReadAndDoMove(board);
             std::cout << board << std::endl;
         }
-        int32_t result = board.FinalEvaluation();
+        int32_t result = board.DiscDifference();
         if (result == 0) {
             std::cout << ("Draw") << std::endl;
         } else if ((result > 0) ^ (board.MySymbol() == 'o')) {
@@ -103,7 +185,20 @@ namespace ReversiEngine {
 
 }// namespace ReversiEngine
 
-int main() {
+int main(int argc, char** argv) {
+    ReversiEngine::Arguments arguments(argc, argv);
+    ReversiEngine::GameOptions options;
+    options.print_stats = arguments.Has("stats");
+    options.perf = arguments.Has("perf");
+    options.weights = arguments.GetString("weights", "");
+    options.network = arguments.GetString("network", "");
+    options.position = arguments.GetString("position", "");
+    options.mcts = arguments.GetString("engine", "alphabeta") == "mcts";
+    options.mcts_settings.threads = static_cast<int32_t>(arguments.GetInt("threads", 1));
+    options.mcts_settings.playouts = !arguments.Has("mcts-evaluation");
+    options.mcts_settings.seed = static_cast<uint64_t>(std::random_device()());
+    options.trace = arguments.GetString("trace", "");
+    options.trace_rate = arguments.GetDouble("trace-rate", 1);
     std::cout << "Are you playing first (yes/no)?" << std::endl;
     std::string str;
     while (str != "yes" && str != "no") {
@@ -113,9 +208,9 @@ int main() {
         }
     }
     if (str == "yes") {
-        ReversiEngine::StartGame(ReversiEngine::First);
+        ReversiEngine::StartGame(ReversiEngine::First, options);
     } else {
-        ReversiEngine::StartGame(ReversiEngine::Second);
+        ReversiEngine::StartGame(ReversiEngine::Second, options);
     }
     return 0;
 }
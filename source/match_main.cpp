@@ -0,0 +1,312 @@
+#include "arguments.h"
+#include "board.h"
+#include "engine.h"
+#include "evaluation.h"
+#include "game_record.h"
+#include "network.h"
+#include "notation.h"
+#include "perf_counters.h"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+namespace ReversiEngine {
+
+    namespace {
+        struct Opening {
+            std::vector<Cell> moves;
+            Board board;
+        };
+
+        struct MatchSettings {
+            SearchLimits limits_a;
+            SearchLimits limits_b;
+            int64_t games = 0;
+            int32_t threads = 1;
+            // Receives the statistics of every search as one JSON object per line.
+            std::ofstream* stats_output = nullptr;
+            std::mutex* stats_mutex = nullptr;
+            bool perf = false;
+            // Leaf evaluation networks of the engines; the built-in evaluation if null.
+            const Network* network_a = nullptr;
+            const Network* network_b = nullptr;
+        };
+
+        SearchLimits ReadLimits(const Arguments& arguments, const std::string& suffix) {
+            SearchLimits limits;
+            limits.depth = static_cast<int32_t>(
+                    arguments.GetInt("depth" + suffix, arguments.GetInt("depth", 6)));
+            limits.nodes = arguments.GetInt("nodes" + suffix, arguments.GetInt("nodes", 0));
+            limits.milliseconds =
+                    arguments.GetInt("time" + suffix, arguments.GetInt("time", 0));
+            return limits;
+        }
+
+        void EnumerateOpenings(const Board& board, int32_t plies, std::vector<Cell>& line,
+                               std::vector<Opening>& openings) {
+            auto moves = board.PossibleMoves();
+            if (plies == 0 || moves.empty()) {
+                openings.push_back({line, board});
+                return;
+            }
+            for (const auto& cell : moves) {
+                line.push_back(cell);
+                EnumerateOpenings(board.MakeMove(cell), plies - 1, line, openings);
+                line.pop_back();
+            }
+        }
+
+        bool LoadOpenings(const std::string& path, std::vector<Opening>& openings) {
+            std::ifstream in(path);
+            if (!in) {
+                return false;
+            }
+            std::string line;
+            while (std::getline(in, line)) {
+                if (line.empty() || line[0] == '#') {
+                    continue;
+                }
+                Opening opening;
+                if (!ParseMoves(line, opening.moves, opening.board)) {
+                    std::cerr << "Illegal opening line: " << line << std::endl;
+                    return false;
+                }
+                openings.push_back(opening);
+            }
+            return true;
+        }
+
+        // Plays one game; engine A moves for the first player iff `a_is_first`.
+        GameRecord PlayGame(const Opening& opening, bool a_is_first, const Engine& a,
+                            const Engine& b, const MatchSettings& settings, int64_t& nodes) {
+            GameRecord record;
+            for (const auto& cell : opening.moves) {
+                record.Append(cell);
+            }
+            Board board = opening.board;
+            std::vector<Cell> moves;
+            while (true) {
+                board.PossibleMoves(moves);
+                if (moves.empty()) {
+                    Board passed = board.MakeMove(Cell{-1, -1});
+                    if (passed.PossibleMoves().empty()) {
+                        break;
+                    }
+                    board = passed;
+                    continue;
+                }
+                Cell cell = moves.front();
+                if (moves.size() > 1) {
+                    bool a_to_move = (board.CurrentPlayer() == First) == a_is_first;
+                    const Engine& engine = a_to_move ? a : b;
+                    cell = engine.Search(board, a_to_move ? settings.limits_a : settings.limits_b)
+                                   .move;
+                    nodes += engine.nodes;
+                    if (settings.stats_output) {
+                        std::lock_guard lock(*settings.stats_mutex);
+                        *settings.stats_output << engine.stats.ToJson() << "\n";
+                    }
+                }
+                record.Append(cell);
+                board = board.MakeMove(cell);
+            }
+            int32_t difference = board.DiscDifference();
+            record.result = static_cast<int8_t>(board.CurrentPlayer() == First ? difference
+                                                                              : -difference);
+            return record;
+        }
+
+        double EloFromScore(double score) {
+            if (score <= 0) {
+                return -INFINITY;
+            }
+            if (score >= 1) {
+                return INFINITY;
+            }
+            return -400.0 * std::log10(1.0 / score - 1.0);
+        }
+
+        void PrintReport(int64_t wins, int64_t draws, int64_t losses) {
+            int64_t games = wins + draws + losses;
+            if (games == 0) {
+                return;
+            }
+            double n = static_cast<double>(games);
+            double score = (static_cast<double>(wins) + 0.5 * static_cast<double>(draws)) / n;
+            double variance = (static_cast<double>(wins) * (1 - score) * (1 - score) +
+                               static_cast<double>(draws) * (0.5 - score) * (0.5 - score) +
+                               static_cast<double>(losses) * score * score) /
+                              n;
+            double margin = 1.96 * std::sqrt(variance / n);
+            std::cout << "Games: " << games << ", A: +" << wins << " =" << draws << " -" << losses
+                      << std::endl;
+            std::cout << std::fixed << std::setprecision(1) << "Score: " << 100 * score
+                      << "%, Elo: " << EloFromScore(score) << " [" << EloFromScore(score - margin)
+                      << ", " << EloFromScore(score + margin) << "] (95%)" << std::endl;
+        }
+    }// namespace
+
+    int RunMatch(const Arguments& arguments) {
+        MatchSettings settings;
+        settings.limits_a = ReadLimits(arguments, "-a");
+        settings.limits_b = ReadLimits(arguments, "-b");
+        settings.threads = static_cast<int32_t>(arguments.GetInt(
+                "threads", std::max(1u, std::thread::hardware_concurrency())));
+
+        Board initial;
+        initial.InitPrecalc();
+        if (arguments.Has("weights") &&
+            !LoadEvaluationWeights(arguments.GetString("weights", ""))) {
+            std::cerr << "Can not load evaluation weights" << std::endl;
+            return 1;
+        }
+        auto load_network = [&](const std::string& name, std::unique_ptr<Network>& network) {
+            if (!arguments.Has(name)) {
+                return true;
+            }
+            network = std::make_unique<Network>();
+            if (!network->Load(arguments.GetString(name, ""))) {
+                std::cerr << "Can not load " << arguments.GetString(name, "") << std::endl;
+                return false;
+            }
+            return true;
+        };
+        std::unique_ptr<Network> network_a;
+        std::unique_ptr<Network> network_b;
+        if (!load_network("network-a", network_a) || !load_network("network-b", network_b)) {
+            return 1;
+        }
+        settings.network_a = network_a.get();
+        settings.network_b = network_b.get();
+        std::vector<Opening> openings;
+        if (arguments.Has("openings")) {
+            if (!LoadOpenings(arguments.GetString("openings", ""), openings)) {
+                std::cerr << "Can not load openings" << std::endl;
+                return 1;
+            }
+        } else {
+            std::vector<Cell> line;
+            EnumerateOpenings(initial, static_cast<int32_t>(arguments.GetInt("opening-plies", 4)),
+                              line, openings);
+        }
+        if (openings.empty()) {
+            std::cerr << "No openings" << std::endl;
+            return 1;
+        }
+        // Every opening is played twice with colors swapped.
+        settings.games = arguments.GetInt("games", 2 * static_cast<int64_t>(openings.size()));
+        std::cout << "Openings: " << openings.size() << ", games: " << settings.games
+                  << ", threads: " << settings.threads << std::endl;
+
+        std::ofstream stats_output;
+        std::mutex stats_mutex;
+        if (arguments.Has("stats")) {
+            stats_output.open(arguments.GetString("stats", ""));
+            settings.stats_output = &stats_output;
+            settings.stats_mutex = &stats_mutex;
+        }
+
+        std::vector<GameRecord> records(settings.games);
+        std::atomic<int64_t> next_game = 0;
+        std::atomic<int64_t> wins = 0;
+        std::atomic<int64_t> draws = 0;
+        std::atomic<int64_t> losses = 0;
+        std::atomic<int64_t> finished = 0;
+        std::mutex output_mutex;
+        settings.perf = arguments.Has("perf");
+        PerfCounters::Values perf_values;
+        int64_t total_nodes = 0;
+        auto start_time = std::chrono::steady_clock::now();
+        int64_t progress_interval = std::max<int64_t>(1, settings.games / 20);
+
+        auto worker = [&]() {
+            Engine engine_a;
+            Engine engine_b;
+            engine_a.network = settings.network_a;
+            engine_b.network = settings.network_b;
+            std::optional<PerfCounters> counters;
+            if (settings.perf) {
+                counters.emplace();
+                counters->Start();
+            }
+            int64_t nodes = 0;
+            for (int64_t game = next_game++; game < settings.games; game = next_game++) {
+                const auto& opening = openings[(game / 2) % openings.size()];
+                bool a_is_first = game % 2 == 0;
+                records[game] = PlayGame(opening, a_is_first, engine_a, engine_b, settings, nodes);
+                int32_t a_result = a_is_first ? records[game].result : -records[game].result;
+                if (a_result > 0) {
+                    ++wins;
+                } else if (a_result < 0) {
+                    ++losses;
+                } else {
+                    ++draws;
+                }
+                if (++finished % progress_interval == 0) {
+                    std::lock_guard lock(output_mutex);
+                    PrintReport(wins, draws, losses);
+                }
+            }
+            std::lock_guard lock(output_mutex);
+            total_nodes += nodes;
+            if (counters) {
+                counters->Stop();
+                perf_values += counters->Read();
+            }
+        };
+        std::vector<std::jthread> threads;
+        for (int32_t i = 0; i < settings.threads; ++i) {
+            threads.emplace_back(worker);
+        }
+        threads.clear();
+
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_time;
+        std::cout << "Final result:" << std::endl;
+        PrintReport(wins, draws, losses);
+        std::cout << "Searched " << total_nodes << " nodes in " << elapsed.count() << " sec ("
+                  << static_cast<int64_t>(static_cast<double>(total_nodes) / elapsed.count())
+                  << " nodes/sec)" << std::endl;
+        if (settings.perf) {
+            std::cout << perf_values.Format(total_nodes, elapsed.count()) << std::endl;
+        }
+
+        if (arguments.Has("output")) {
+            GameWriter writer(arguments.GetString("output", ""));
+            for (const auto& record : records) {
+                writer.Write(record);
+            }
+            if (!writer.Close()) {
+                std::cerr << "Can not write games" << std::endl;
+                return 1;
+            }
+        }
+        return 0;
+    }
+
+}// namespace ReversiEngine
+
+int main(int argc, char** argv) {
+    ReversiEngine::Arguments arguments(argc, argv);
+    if (arguments.Has("help")) {
+        std::cout << "Usage: reversi-match [--threads=N] [--games=N] [--openings=FILE | "
+                     "--opening-plies=N]\n"
+                     "                     [--depth[-a|-b]=N] [--nodes[-a|-b]=N] "
+                     "[--time[-a|-b]=MS] [--output=FILE]\n"
+                     "                     [--stats=FILE] [--perf] [--weights=FILE]\n"
+                     "                     [--network-a=FILE] [--network-b=FILE]\n"
+                     "Plays engine A against engine B from every opening with colors swapped.\n"
+                     "--weights replaces the evaluation weights of both engines, --network-a\n"
+                     "and --network-b make one engine evaluate leaves with a network."
+                  << std::endl;
+        return 0;
+    }
+    return ReversiEngine::RunMatch(arguments);
+}
@@ -0,0 +1,218 @@
+#include "mcts.h"
+#include "playout.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <limits>
+#include <thread>
+#include <vector>
+
+namespace ReversiEngine {
+
+    namespace {
+        const int64_t VALUE_SCALE = 1 << 16;
+
+        // Evaluation units per logistic unit when turning an evaluation into a win probability.
+        const double EVALUATION_SCALE = 200;
+
+        // Evaluation units per e-fold of the move priors.
+        const double PRIOR_TEMPERATURE = 100;
+
+        // Playouts between two checks of the clock.
+        const int64_t CLOCK_INTERVAL = 256;
+
+        Cell SquareCell(int32_t square) {
+            return square < 0 ? Cell{-1, -1} : Cell{square >> 3, square & 7};
+        }
+
+        int64_t WinValue(double probability) {
+            return static_cast<int64_t>(probability * static_cast<double>(VALUE_SCALE));
+        }
+
+        // Result of a random game from `board` for its side to move.
+        int64_t PlayoutValue(const Board& board, Xorshift64& random) {
+            int32_t score = Playout(PlayoutPosition(board), random);
+            return score > 0 ? VALUE_SCALE : score < 0 ? 0 : VALUE_SCALE / 2;
+        }
+
+        int64_t EvaluationValue(const Board& board) {
+            return WinValue(1 / (1 + std::exp(-board.FinalEvaluation() / EVALUATION_SCALE)));
+        }
+    }// namespace
+
+    MctsEngine::MctsEngine(const MctsSettings& settings)
+        : settings_(settings), nodes_(std::make_unique<Node[]>(settings.max_nodes)) {
+    }
+
+    void MctsEngine::Expand(Node& node, const Board& board) {
+        uint64_t moves = board.PossibleMovesMask().to_ullong();
+        auto count = static_cast<uint32_t>(std::max(std::popcount(moves), 1));
+        // Checked before allocating so that a full arena stays full instead of overflowing.
+        uint32_t first = used_.load(std::memory_order_relaxed);
+        if (first + count > settings_.max_nodes ||
+            (first = used_.fetch_add(count)) + count > settings_.max_nodes) {
+            node.state.store(Leaf, std::memory_order_release);
+            return;
+        }
+        std::array<int32_t, 64> evaluations{};
+        int32_t max_evaluation = std::numeric_limits<int32_t>::min();
+        for (uint32_t i = 0; i < count; ++i) {
+            Node& child = nodes_[first + i];
+            int32_t square = moves ? std::countr_zero(moves) : -1;
+            moves &= moves - 1;
+            child.visits.store(0, std::memory_order_relaxed);
+            child.value.store(0, std::memory_order_relaxed);
+            child.state.store(Leaf, std::memory_order_relaxed);
+            child.square = static_cast<int8_t>(square);
+            if (!settings_.playouts) {
+                evaluations[i] = -board.MakeMove(SquareCell(square)).FinalEvaluation();
+            }
+            max_evaluation = std::max(max_evaluation, evaluations[i]);
+        }
+        // Relative to the best child, so that the exponentials can not overflow.
+        std::array<double, 64> priors{};
+        double prior_sum = 0;
+        for (uint32_t i = 0; i < count; ++i) {
+            priors[i] = std::exp((evaluations[i] - max_evaluation) / PRIOR_TEMPERATURE);
+            prior_sum += priors[i];
+        }
+        for (uint32_t i = 0; i < count; ++i) {
+            nodes_[first + i].prior = static_cast<float>(priors[i] / prior_sum);
+        }
+        node.children = first;
+        node.child_count = static_cast<uint8_t>(count);
+        node.state.store(Expanded, std::memory_order_release);
+    }
+
+    uint32_t MctsEngine::SelectChild(const Node& node) const {
+        auto parent_visits = static_cast<double>(node.visits.load(std::memory_order_relaxed));
+        double parent_value =
+                static_cast<double>(node.value.load(std::memory_order_relaxed)) /
+                static_cast<double>(VALUE_SCALE) / std::max(parent_visits, 1.0);
+        double log_visits = std::log(std::max(parent_visits, 1.0));
+        uint32_t best = node.children;
+        double best_score = -1;
+        for (uint32_t i = node.children; i < node.children + node.child_count; ++i) {
+            const Node& child = nodes_[i];
+            auto visits = static_cast<double>(child.visits.load(std::memory_order_relaxed));
+            double value = static_cast<double>(child.value.load(std::memory_order_relaxed)) /
+                           static_cast<double>(VALUE_SCALE);
+            double score;
+            if (settings_.playouts) {
+                if (visits == 0) {
+                    return i;
+                }
+                score = value / visits + settings_.exploration * std::sqrt(log_visits / visits);
+            } else {
+                // Unvisited moves start from the value the parent has for the opponent.
+                double mean = visits > 0 ? value / visits : 1 - parent_value;
+                score = mean + settings_.exploration * child.prior * std::sqrt(parent_visits) /
+                                       (1 + visits);
+            }
+            if (score > best_score) {
+                best_score = score;
+                best = i;
+            }
+        }
+        return best;
+    }
+
+    void MctsEngine::Worker(const Board& root, const SearchLimits& limits, int32_t thread) {
+        Xorshift64 random((settings_.seed + static_cast<uint64_t>(thread) + 1) *
+                          0x9E3779B97F4A7C15ULL);
+        std::vector<uint32_t> path;
+        while (!stop) {
+            int64_t playout = playouts_++;
+            if (limits.nodes > 0 && playout >= limits.nodes) {
+                break;
+            }
+            if (playout % CLOCK_INTERVAL == 0 && std::chrono::steady_clock::now() >= deadline_) {
+                stop = true;
+                break;
+            }
+            Board board = root;
+            path.assign(1, 0);
+            nodes_[0].visits.fetch_add(1, std::memory_order_relaxed);
+            int64_t result = 0;// for the side to move at `board`
+            while (true) {
+                Node& node = nodes_[path.back()];
+                if (board.GameEnded()) {
+                    int32_t score = board.DiscDifference();
+                    result = score > 0 ? VALUE_SCALE : score < 0 ? 0 : VALUE_SCALE / 2;
+                    break;
+                }
+                State state = node.state.load(std::memory_order_acquire);
+                if (state == Leaf && (path.size() == 1 || node.visits > 1)) {
+                    if (node.state.compare_exchange_strong(state, Expanding,
+                                                           std::memory_order_acquire)) {
+                        Expand(node, board);
+                        state = node.state.load(std::memory_order_acquire);
+                    }
+                }
+                if (state != Expanded) {
+                    result = settings_.playouts ? PlayoutValue(board, random)
+                                                : EvaluationValue(board);
+                    break;
+                }
+                uint32_t child = SelectChild(node);
+                nodes_[child].visits.fetch_add(1, std::memory_order_relaxed);
+                board = board.MakeMove(SquareCell(nodes_[child].square));
+                path.push_back(child);
+            }
+            auto depth = static_cast<int32_t>(path.size()) - 1;
+            int32_t max_depth = max_depth_.load(std::memory_order_relaxed);
+            while (depth > max_depth && !max_depth_.compare_exchange_weak(max_depth, depth)) {
+            }
+            // The last node was entered by the opponent of the side to move at the leaf.
+            for (auto it = path.rbegin(); it != path.rend(); ++it) {
+                result = VALUE_SCALE - result;
+                nodes_[*it].value.fetch_add(result, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    SearchResult MctsEngine::Search(const Board& board, const SearchLimits& limits) {
+        stop = false;
+        playouts_ = 0;
+        max_depth_ = 0;
+        used_ = 1;
+        nodes_[0].visits = 0;
+        nodes_[0].value = 0;
+        nodes_[0].state = Leaf;
+        deadline_ = std::chrono::steady_clock::time_point::max();
+        if (limits.milliseconds > 0) {
+            deadline_ = std::chrono::steady_clock::now() +
+                        std::chrono::milliseconds(limits.milliseconds);
+        }
+        {
+            std::vector<std::jthread> workers;
+            for (int32_t i = 0; i < std::max(settings_.threads, 1); ++i) {
+                workers.emplace_back(&MctsEngine::Worker, this, std::cref(board), std::cref(limits),
+                                     i);
+            }
+        }
+        SearchResult result;
+        result.nodes = std::min(playouts_.load(), limits.nodes > 0 ? limits.nodes : INT64_MAX);
+        result.depth = max_depth_;
+        const Node& root = nodes_[0];
+        if (root.state.load(std::memory_order_acquire) != Expanded) {
+            return result;
+        }
+        const Node* best = nullptr;
+        for (uint32_t i = root.children; i < root.children + root.child_count; ++i) {
+            if (!best || nodes_[i].visits > best->visits) {
+                best = &nodes_[i];
+            }
+        }
+        result.move = SquareCell(best->square);
+        if (best->visits > 0) {
+            double win = static_cast<double>(best->value) / static_cast<double>(VALUE_SCALE) /
+                         static_cast<double>(best->visits);
+            result.score = static_cast<int32_t>(std::lround(200 * win - 100));
+        }
+        return result;
+    }
+
+}// namespace ReversiEngine
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "board.h"
+#include "engine.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace ReversiEngine {
+
+    struct MctsSettings {
+        int32_t threads = 1;
+        // Capacity of the node arena; the tree stops growing when it is full.
+        uint32_t max_nodes = 1 << 20;
+        double exploration = 1.0;
+        // Leaves are scored by one random playout, else by the static evaluation (which also
+        // gives the move priors).
+        bool playouts = true;
+        uint64_t seed = 0;
+    };
+
+    // Monte Carlo tree search. With random playouts children are selected by UCT, with the
+    // evaluation by PUCT with priors from a softmax over the children's evaluations. Threads
+    // share one tree: a thread counts its visit on the way down and adds the result on the way
+    // up, so a pending visit counts as a loss (virtual loss) and steers other threads to other
+    // moves.
+    class MctsEngine {
+    public:
+        explicit MctsEngine(const MctsSettings& settings);
+
+        // Runs until limits.nodes playouts are done or the time is up (depth is ignored). The
+        // score is the win probability of the chosen move scaled to [-100, 100]; depth is the
+        // deepest path in the tree and nodes the number of playouts.
+        [[nodiscard]] SearchResult Search(const Board& board, const SearchLimits& limits);
+
+        std::atomic<bool> stop = false;
+
+    private:
+        enum State : uint8_t { Leaf, Expanding, Expanded };
+
+        struct Node {
+            std::atomic<int32_t> visits{0};
+            // Sum of the results for the player who moved into the node, VALUE_SCALE per win.
+            std::atomic<int64_t> value{0};
+            std::atomic<State> state{Leaf};
+            uint32_t children = 0;
+            uint8_t child_count = 0;
+            int8_t square = -1;
+            float prior = 0;
+        };
+
+        void Worker(const Board& root, const SearchLimits& limits, int32_t thread);
+
+        // Creates the children of a node whose state this thread switched to Expanding.
+        void Expand(Node& node, const Board& board);
+
+        [[nodiscard]] uint32_t SelectChild(const Node& node) const;
+
+        MctsSettings settings_;
+        std::unique_ptr<Node[]> nodes_;
+        std::atomic<uint32_t> used_ = 0;
+        std::atomic<int64_t> playouts_ = 0;
+        std::atomic<int32_t> max_depth_ = 0;
+        std::chrono::steady_clock::time_point deadline_;
+    };
+
+}// namespace ReversiEngine
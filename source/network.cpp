@@ -0,0 +1,247 @@
+#include "network.h"
+#include "evaluation.h"
+
+#include <algorithm>
+#include <bit>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <vector>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace ReversiEngine {
+
+    namespace {
+        // Above this number of changed squares a full refresh is cheaper than an update.
+        const int32_t REFRESH_SQUARES = 24;
+
+        using Row = std::array<int16_t, Network::SIZE>;
+
+        // Adds the rows of the squares in `added` (offset by `offset` inputs) to `values` and
+        // subtracts those in `removed`.
+        void ApplySquares(Row& values, const std::array<Row, Network::INPUTS>& rows,
+                          uint64_t added, uint64_t removed, int32_t offset) {
+            for (; added; added &= added - 1) {
+                const Row& row = rows[offset + std::countr_zero(added)];
+                for (int32_t i = 0; i < Network::SIZE; ++i) {
+                    values[i] = static_cast<int16_t>(values[i] + row[i]);
+                }
+            }
+            for (; removed; removed &= removed - 1) {
+                const Row& row = rows[offset + std::countr_zero(removed)];
+                for (int32_t i = 0; i < Network::SIZE; ++i) {
+                    values[i] = static_cast<int16_t>(values[i] - row[i]);
+                }
+            }
+        }
+
+#ifdef __AVX2__
+        inline int32_t HorizontalSum(__m256i sums) {
+            __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(sums),
+                                        _mm256_extracti128_si256(sums, 1));
+            sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+            sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+            return _mm_cvtsi128_si32(sum);
+        }
+
+        // Sum of 32 unsigned by signed byte products, as 8 int32 lanes.
+        inline __m256i DotProduct(__m256i inputs, __m256i weights) {
+            return _mm256_madd_epi16(_mm256_maddubs_epi16(inputs, weights),
+                                     _mm256_set1_epi16(1));
+        }
+#endif
+    }// namespace
+
+    bool Network::Load(const std::string& path) {
+        std::ifstream in(path);
+        if (!in) {
+            return false;
+        }
+        std::vector<int64_t> values;
+        std::string line;
+        while (std::getline(in, line)) {
+            std::istringstream numbers(line.substr(0, line.find('#')));
+            int64_t value;
+            while (numbers >> value) {
+                values.push_back(value);
+            }
+            if (!numbers.eof()) {
+                return false;
+            }
+        }
+        const size_t expected = (INPUTS + 1) * SIZE + HIDDEN * (SIZE + 2) + 1;
+        if (values.size() != expected) {
+            return false;
+        }
+        Network result;
+        size_t next = 0;
+        bool in_range = true;
+        auto read = [&]<typename T>(T& target) {
+            int64_t value = values[next++];
+            in_range = in_range && value >= std::numeric_limits<T>::min() &&
+                       value <= std::numeric_limits<T>::max();
+            target = static_cast<T>(value);
+        };
+        for (auto& row : result.input_weights_) {
+            std::for_each(row.begin(), row.end(), read);
+        }
+        std::for_each(result.input_biases_.begin(), result.input_biases_.end(), read);
+        for (auto& row : result.hidden_weights_) {
+            std::for_each(row.begin(), row.end(), read);
+        }
+        std::for_each(result.hidden_biases_.begin(), result.hidden_biases_.end(), read);
+        std::for_each(result.output_weights_.begin(), result.output_weights_.end(), read);
+        read(result.output_bias_);
+        if (!in_range) {
+            return false;
+        }
+        *this = result;
+        return true;
+    }
+
+    void Network::Refresh(NetworkAccumulator& accumulator, uint64_t first, uint64_t second) const {
+        accumulator.values = {input_biases_, input_biases_};
+        ApplySquares(accumulator.values[First], input_weights_, first, 0, 0);
+        ApplySquares(accumulator.values[First], input_weights_, second, 0, 64);
+        ApplySquares(accumulator.values[Second], input_weights_, second, 0, 0);
+        ApplySquares(accumulator.values[Second], input_weights_, first, 0, 64);
+        accumulator.discs = {first, second};
+        accumulator.valid = true;
+    }
+
+    void Network::Update(NetworkAccumulator& accumulator, const Board& board) const {
+        Update(accumulator, accumulator, board);
+    }
+
+    void Network::Update(const NetworkAccumulator& parent, NetworkAccumulator& accumulator,
+                         const Board& board) const {
+        uint64_t own = board.OwnDiscs().to_ullong();
+        uint64_t opponent = board.OpponentDiscs().to_ullong();
+        uint64_t first = board.CurrentPlayer() == First ? own : opponent;
+        uint64_t second = board.CurrentPlayer() == First ? opponent : own;
+        uint64_t changed = (parent.discs[First] ^ first) | (parent.discs[Second] ^ second);
+        if (!parent.valid || std::popcount(changed) > REFRESH_SQUARES) {
+            Refresh(accumulator, first, second);
+            return;
+        }
+        uint64_t added_first = first & ~parent.discs[First];
+        uint64_t removed_first = parent.discs[First] & ~first;
+        uint64_t added_second = second & ~parent.discs[Second];
+        uint64_t removed_second = parent.discs[Second] & ~second;
+#ifdef __AVX2__
+        // Each point of view stays in four registers while all its rows are applied.
+        auto apply = [&](const Row& from, Row& values, uint64_t own_added, uint64_t own_removed,
+                         uint64_t opponent_added, uint64_t opponent_removed) {
+            const auto* source = reinterpret_cast<const __m256i*>(from.data());
+            __m256i sums[4] = {_mm256_load_si256(source), _mm256_load_si256(source + 1),
+                               _mm256_load_si256(source + 2), _mm256_load_si256(source + 3)};
+            auto add = [&](uint64_t squares, int32_t offset, bool subtract) {
+                for (; squares; squares &= squares - 1) {
+                    const auto* row = reinterpret_cast<const __m256i*>(
+                            input_weights_[offset + std::countr_zero(squares)].data());
+                    for (int32_t i = 0; i < 4; ++i) {
+                        __m256i weights = _mm256_load_si256(row + i);
+                        sums[i] = subtract ? _mm256_sub_epi16(sums[i], weights)
+                                           : _mm256_add_epi16(sums[i], weights);
+                    }
+                }
+            };
+            add(own_added, 0, false);
+            add(own_removed, 0, true);
+            add(opponent_added, 64, false);
+            add(opponent_removed, 64, true);
+            auto* data = reinterpret_cast<__m256i*>(values.data());
+            for (int32_t i = 0; i < 4; ++i) {
+                _mm256_store_si256(data + i, sums[i]);
+            }
+        };
+        static_assert(SIZE == 64);
+        apply(parent.values[First], accumulator.values[First], added_first, removed_first,
+              added_second, removed_second);
+        apply(parent.values[Second], accumulator.values[Second], added_second, removed_second,
+              added_first, removed_first);
+#else
+        if (&parent != &accumulator) {
+            accumulator.values = parent.values;
+        }
+        ApplySquares(accumulator.values[First], input_weights_, added_first, removed_first, 0);
+        ApplySquares(accumulator.values[First], input_weights_, added_second, removed_second, 64);
+        ApplySquares(accumulator.values[Second], input_weights_, added_second, removed_second, 0);
+        ApplySquares(accumulator.values[Second], input_weights_, added_first, removed_first, 64);
+#endif
+        accumulator.discs = {first, second};
+        accumulator.valid = true;
+    }
+
+    int32_t Network::Evaluate(const NetworkAccumulator& accumulator, Player player) const {
+        const Row& values = accumulator.values[player];
+        int32_t output = output_bias_;
+#ifdef __AVX2__
+        static_assert(SIZE == 64 && HIDDEN == 32);
+        // Clip to [0, 127] as bytes; packing interleaves the 128-bit lanes, the permute undoes it.
+        const auto* data = reinterpret_cast<const __m256i*>(values.data());
+        __m256i zero = _mm256_setzero_si256();
+        __m256i inputs[2];
+        for (int32_t i = 0; i < 2; ++i) {
+            __m256i packed = _mm256_packs_epi16(_mm256_load_si256(data + 2 * i),
+                                                _mm256_load_si256(data + 2 * i + 1));
+            inputs[i] = _mm256_max_epi8(_mm256_permute4x64_epi64(packed, 0xD8), zero);
+        }
+        // Eight neurons at a time: their eight-lane sums are reduced into one register.
+        alignas(32) std::array<uint8_t, HIDDEN> hidden;
+        __m256i hidden_sums[HIDDEN / 8];
+        for (int32_t group = 0; group < HIDDEN / 8; ++group) {
+            __m256i sums[8];
+            for (int32_t k = 0; k < 8; ++k) {
+                const auto* weights =
+                        reinterpret_cast<const __m256i*>(hidden_weights_[group * 8 + k].data());
+                sums[k] = _mm256_add_epi32(DotProduct(inputs[0], _mm256_load_si256(weights)),
+                                           DotProduct(inputs[1], _mm256_load_si256(weights + 1)));
+            }
+            __m256i pairs[4];
+            for (int32_t k = 0; k < 4; ++k) {
+                pairs[k] = _mm256_hadd_epi32(sums[2 * k], sums[2 * k + 1]);
+            }
+            // Per 128-bit lane: the low and the high four neurons, each summed over that lane.
+            __m256i low = _mm256_hadd_epi32(pairs[0], pairs[1]);
+            __m256i high = _mm256_hadd_epi32(pairs[2], pairs[3]);
+            __m256i total = _mm256_add_epi32(_mm256_permute2x128_si256(low, high, 0x20),
+                                             _mm256_permute2x128_si256(low, high, 0x31));
+            hidden_sums[group] = _mm256_srai_epi32(
+                    _mm256_add_epi32(total, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(
+                                                    hidden_biases_.data() + group * 8))),
+                    HIDDEN_SHIFT);
+        }
+        // Saturating packs clip to [0, 127] once negative values are cut at 0.
+        __m256i words = _mm256_packs_epi32(hidden_sums[0], hidden_sums[1]);
+        __m256i words2 = _mm256_packs_epi32(hidden_sums[2], hidden_sums[3]);
+        __m256i bytes = _mm256_max_epi8(_mm256_packs_epi16(words, words2), zero);
+        // Both packs interleave 128-bit lanes and 64-bit halves: undo with one permutation.
+        bytes = _mm256_permutevar8x32_epi32(bytes, _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7));
+        _mm256_store_si256(reinterpret_cast<__m256i*>(hidden.data()), bytes);
+        output += HorizontalSum(
+                DotProduct(_mm256_load_si256(reinterpret_cast<const __m256i*>(hidden.data())),
+                           _mm256_load_si256(
+                                   reinterpret_cast<const __m256i*>(output_weights_.data()))));
+#else
+        std::array<int16_t, SIZE> inputs;
+        for (int32_t i = 0; i < SIZE; ++i) {
+            inputs[i] = std::clamp<int16_t>(values[i], 0, 127);
+        }
+        for (int32_t j = 0; j < HIDDEN; ++j) {
+            int32_t sum = 0;
+            for (int32_t i = 0; i < SIZE; ++i) {
+                sum += static_cast<int16_t>(inputs[i] * hidden_weights_[j][i]);
+            }
+            sum = (sum + hidden_biases_[j]) >> HIDDEN_SHIFT;
+            output += std::clamp(sum, 0, 127) * output_weights_[j];
+        }
+#endif
+        return std::clamp(output >> OUTPUT_SHIFT, -EvaluationWeights::MAX_EVALUATION,
+                          EvaluationWeights::MAX_EVALUATION);
+    }
+
+}// namespace ReversiEngine
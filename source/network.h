@@ -0,0 +1,67 @@
+#pragma once
+
+#include "board.h"
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+namespace ReversiEngine {
+
+    // First layer outputs of a position for both players' points of view, with the discs they
+    // were computed for so that the next position can be reached by an incremental update.
+    struct alignas(32) NetworkAccumulator {
+        static constexpr int32_t SIZE = 64;
+
+        // Indexed by the player whose discs are the "own" inputs.
+        std::array<std::array<int16_t, SIZE>, 2> values{};
+        std::array<uint64_t, 2> discs{};// of the first and second player
+        bool valid = false;
+    };
+
+    // Small quantized network evaluation (NNUE style). 128 inputs (own and opponent disc on
+    // every square) feed SIZE int16 first layer outputs, which are kept in an accumulator and
+    // updated from the squares a move changes. The side to move's outputs are clipped to
+    // [0, 127] and go through an int8 dense layer of HIDDEN outputs and an int8 output layer.
+    class Network {
+    public:
+        static constexpr int32_t INPUTS = 128;
+        static constexpr int32_t SIZE = NetworkAccumulator::SIZE;
+        static constexpr int32_t HIDDEN = 32;
+        // Right shifts applied to the hidden layer sums and to the output.
+        static constexpr int32_t HIDDEN_SHIFT = 6;
+        static constexpr int32_t OUTPUT_SHIFT = 4;
+
+        // All weights zero: every position evaluates to 0.
+        Network() = default;
+
+        // Text file of integers, '#' starts a comment: INPUTS rows of SIZE first layer weights
+        // (inputs a1..h8 own, then a1..h8 opponent), SIZE first layer biases, HIDDEN rows of
+        // SIZE hidden weights, HIDDEN hidden biases, HIDDEN output weights and the output bias.
+        [[nodiscard]] bool Load(const std::string& path);
+
+        // Brings `accumulator` to the discs of `board`, updating only the squares that differ
+        // from the discs it holds, or recomputing it when it holds nothing useful.
+        void Update(NetworkAccumulator& accumulator, const Board& board) const;
+
+        // Same with `parent` as the starting point, typically the position before the move.
+        void Update(const NetworkAccumulator& parent, NetworkAccumulator& accumulator,
+                    const Board& board) const;
+
+        // Evaluation of an up to date accumulator for `player` to move, in the units of
+        // Board::FinalEvaluation.
+        [[nodiscard]] int32_t Evaluate(const NetworkAccumulator& accumulator,
+                                       Player player) const;
+
+    private:
+        void Refresh(NetworkAccumulator& accumulator, uint64_t first, uint64_t second) const;
+
+        alignas(32) std::array<std::array<int16_t, SIZE>, INPUTS> input_weights_{};
+        alignas(32) std::array<int16_t, SIZE> input_biases_{};
+        alignas(32) std::array<std::array<int8_t, SIZE>, HIDDEN> hidden_weights_{};
+        std::array<int32_t, HIDDEN> hidden_biases_{};
+        alignas(32) std::array<int8_t, HIDDEN> output_weights_{};
+        int32_t output_bias_ = 0;
+    };
+
+}// namespace ReversiEngine
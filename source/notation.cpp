@@ -0,0 +1,137 @@
+#include "notation.h"
+
+#include "game_record.h"
+
+#include <cctype>
+#include <sstream>
+
+namespace ReversiEngine {
+
+    namespace {
+        const uint64_t D4 = uint64_t{1} << 27;
+    }// namespace
+
+    std::optional<Cell> ParseCell(std::string_view text) {
+        if (text.size() != 2) {
+            return std::nullopt;
+        }
+        int32_t col = std::tolower(static_cast<unsigned char>(text[0])) - 'a';
+        int32_t row = text[1] - '1';
+        if (col < 0 || col > 7 || row < 0 || row > 7) {
+            return std::nullopt;
+        }
+        return Cell{row, col};
+    }
+
+    bool ParseMoves(std::string_view text, std::vector<Cell>& moves, Board& board) {
+        moves.clear();
+        board = Board();
+        size_t position = 0;
+        while (position < text.size()) {
+            if (!std::isalpha(static_cast<unsigned char>(text[position]))) {
+                ++position;
+                continue;
+            }
+            auto cell = ParseCell(text.substr(position, 2));
+            if (!cell) {
+                return false;
+            }
+            position += 2;
+            if (!ReplayMove(board, *cell)) {
+                return false;
+            }
+            moves.push_back(*cell);
+        }
+        return true;
+    }
+
+    bool ParsePosition(std::string_view text, Board& board) {
+        if (text.size() < POSITION_TEXT_LENGTH || (text[64] != ' ' && text[64] != '\t')) {
+            return false;
+        }
+        uint64_t first = 0;
+        uint64_t second = 0;
+        for (size_t i = 0; i < 64; ++i) {
+            switch (text[i]) {
+                case 'X':
+                case 'x':
+                case '*':
+                    first |= uint64_t{1} << i;
+                    break;
+                case 'O':
+                case 'o':
+                    second |= uint64_t{1} << i;
+                    break;
+                case '-':
+                case '.':
+                    break;
+                default:
+                    return false;
+            }
+        }
+        char side = text[65];
+        if (side != 'X' && side != 'x' && side != 'O' && side != 'o') {
+            return false;
+        }
+        board = Board(Bitset64(first), Bitset64(second),
+                      side == 'X' || side == 'x' ? First : Second);
+        return true;
+    }
+
+    std::array<char, POSITION_TEXT_LENGTH> FormatPosition(const Board& board) {
+        bool first_to_move = board.CurrentPlayer() == First;
+        uint64_t first = (first_to_move ? board.OwnDiscs() : board.OpponentDiscs()).to_ullong();
+        uint64_t second = (first_to_move ? board.OpponentDiscs() : board.OwnDiscs()).to_ullong();
+        std::array<char, POSITION_TEXT_LENGTH> text{};
+        for (size_t i = 0; i < 64; ++i) {
+            text[i] = (first >> i) & 1 ? 'X' : (second >> i) & 1 ? 'O' : '-';
+        }
+        text[64] = ' ';
+        text[65] = first_to_move ? 'X' : 'O';
+        return text;
+    }
+
+    bool PackPosition(const Board& board, PackedPosition& packed) {
+        bool first_to_move = board.CurrentPlayer() == First;
+        uint64_t first = (first_to_move ? board.OwnDiscs() : board.OpponentDiscs()).to_ullong();
+        uint64_t second = (first_to_move ? board.OpponentDiscs() : board.OwnDiscs()).to_ullong();
+        if (((first | second) & D4) == 0) {
+            return false;
+        }
+        if (!first_to_move) {
+            second ^= D4;
+        }
+        for (size_t i = 0; i < 8; ++i) {
+            packed[i] = static_cast<uint8_t>(first >> (8 * i));
+            packed[8 + i] = static_cast<uint8_t>(second >> (8 * i));
+        }
+        return true;
+    }
+
+    bool UnpackPosition(const PackedPosition& packed, Board& board) {
+        uint64_t first = 0;
+        uint64_t second = 0;
+        for (size_t i = 0; i < 8; ++i) {
+            first |= static_cast<uint64_t>(packed[i]) << (8 * i);
+            second |= static_cast<uint64_t>(packed[8 + i]) << (8 * i);
+        }
+        // Exactly one of the players has a disc on d4, so the second player's d4 bit is known.
+        bool second_on_d4 = (first & D4) == 0;
+        bool first_to_move = ((second & D4) != 0) == second_on_d4;
+        second = (second & ~D4) | (second_on_d4 ? D4 : 0);
+        if (first & second) {
+            return false;
+        }
+        board = Board(Bitset64(first), Bitset64(second), first_to_move ? First : Second);
+        return true;
+    }
+
+    std::string FormatMoves(const std::vector<Cell>& moves) {
+        std::ostringstream out;
+        for (const auto& cell : moves) {
+            out << cell;
+        }
+        return out.str();
+    }
+
+}// namespace ReversiEngine
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "board.h"
+#include "cell.h"
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ReversiEngine {
+
+    // Parses a square written as by Cell's operator<< ("d3"). Letters may be upper case.
+    [[nodiscard]] std::optional<Cell> ParseCell(std::string_view text);
+
+    // Parses a move sequence such as "f5d6c3" (separators are allowed) and checks that it is
+    // legal from the initial position. Passes are implicit: a side without moves passes
+    // automatically. On success `board` holds the final position.
+    [[nodiscard]] bool ParseMoves(std::string_view text, std::vector<Cell>& moves, Board& board);
+
+    [[nodiscard]] std::string FormatMoves(const std::vector<Cell>& moves);
+
+    // Length of a text position: the 64 squares from a1 to h8 (X for the first player, O for the
+    // second, - for empty), a space and the side to move (X or O), as in obf files.
+    constexpr size_t POSITION_TEXT_LENGTH = 66;
+
+    // Parses a text position; lower case, '*' for X and '.' for empty are accepted too. Text
+    // after the side to move is ignored.
+    [[nodiscard]] bool ParsePosition(std::string_view text, Board& board);
+
+    [[nodiscard]] std::array<char, POSITION_TEXT_LENGTH> FormatPosition(const Board& board);
+
+    // 16 bytes: the discs of the first and of the second player as little-endian bitboards. d4
+    // is never empty in a game, so its bit in the second bitboard is xor-ed with the side to
+    // move (set if the second player is to move).
+    using PackedPosition = std::array<uint8_t, 16>;
+
+    // Fails if d4 is empty.
+    [[nodiscard]] bool PackPosition(const Board& board, PackedPosition& packed);
+
+    // Fails if the bitboards overlap.
+    [[nodiscard]] bool UnpackPosition(const PackedPosition& packed, Board& board);
+
+}// namespace ReversiEngine
@@ -0,0 +1,146 @@
+#include "perf_counters.h"
+
+#include <iomanip>
+#include <sstream>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace ReversiEngine {
+
+    namespace {
+        const std::array<const char*, PerfCounters::Event::Count> EVENT_NAMES = {
+                "cycles", "instructions", "branch-misses", "L1d-misses", "LLC-misses",
+                "dTLB-misses"};
+
+#ifdef __linux__
+        int OpenEvent(uint32_t type, uint64_t config) {
+            perf_event_attr attributes{};
+            attributes.size = sizeof(attributes);
+            attributes.type = type;
+            attributes.config = config;
+            attributes.disabled = 1;
+            attributes.exclude_kernel = 1;
+            attributes.exclude_hv = 1;
+            attributes.read_format =
+                    PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            return static_cast<int>(syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0));
+        }
+
+        uint64_t CacheMissConfig(uint64_t cache) {
+            return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                   (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        }
+#endif
+    }// namespace
+
+    PerfCounters::PerfCounters() {
+        descriptors_.fill(-1);
+#ifdef __linux__
+        descriptors_[Cycles] = OpenEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+        descriptors_[Instructions] = OpenEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+        descriptors_[BranchMisses] = OpenEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+        descriptors_[L1DataMisses] =
+                OpenEvent(PERF_TYPE_HW_CACHE, CacheMissConfig(PERF_COUNT_HW_CACHE_L1D));
+        descriptors_[LastLevelMisses] =
+                OpenEvent(PERF_TYPE_HW_CACHE, CacheMissConfig(PERF_COUNT_HW_CACHE_LL));
+        descriptors_[DataTlbMisses] =
+                OpenEvent(PERF_TYPE_HW_CACHE, CacheMissConfig(PERF_COUNT_HW_CACHE_DTLB));
+#endif
+    }
+
+    PerfCounters::~PerfCounters() {
+#ifdef __linux__
+        for (int descriptor : descriptors_) {
+            if (descriptor >= 0) {
+                close(descriptor);
+            }
+        }
+#endif
+    }
+
+    bool PerfCounters::Available() const {
+        for (int descriptor : descriptors_) {
+            if (descriptor >= 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void PerfCounters::Start() {
+#ifdef __linux__
+        for (int descriptor : descriptors_) {
+            if (descriptor >= 0) {
+                ioctl(descriptor, PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+#endif
+    }
+
+    void PerfCounters::Stop() {
+#ifdef __linux__
+        for (int descriptor : descriptors_) {
+            if (descriptor >= 0) {
+                ioctl(descriptor, PERF_EVENT_IOC_DISABLE, 0);
+            }
+        }
+#endif
+    }
+
+    PerfCounters::Values PerfCounters::Read() const {
+        Values values;
+#ifdef __linux__
+        for (int event = 0; event < Event::Count; ++event) {
+            std::array<uint64_t, 3> data{};// value, time enabled, time running
+            if (descriptors_[event] < 0 ||
+                read(descriptors_[event], data.data(), sizeof(data)) != sizeof(data)) {
+                continue;
+            }
+            values.available[event] = true;
+            values.counts[event] = static_cast<double>(data[0]);
+            if (data[2] > 0 && data[2] < data[1]) {
+                values.counts[event] *= static_cast<double>(data[1]) / static_cast<double>(data[2]);
+            }
+        }
+#endif
+        return values;
+    }
+
+    PerfCounters::Values& PerfCounters::Values::operator+=(const Values& other) {
+        for (int event = 0; event < Event::Count; ++event) {
+            counts[event] += other.counts[event];
+            available[event] = available[event] || other.available[event];
+        }
+        return *this;
+    }
+
+    std::string PerfCounters::Values::Format(int64_t nodes, double seconds) const {
+        std::ostringstream out;
+        out << std::fixed << std::setprecision(2);
+        bool first = true;
+        for (int event = 0; event < Event::Count; ++event) {
+            if (!available[event]) {
+                continue;
+            }
+            out << (first ? "" : ", ") << EVENT_NAMES[event] << "/node="
+                << (nodes > 0 ? counts[event] / static_cast<double>(nodes) : 0);
+            first = false;
+        }
+        if (available[Cycles] && available[Instructions] && counts[Cycles] > 0) {
+            out << ", IPC=" << counts[Instructions] / counts[Cycles];
+        }
+        if (available[Cycles] && seconds > 0) {
+            out << ", Gcycles/sec=" << counts[Cycles] / seconds / 1e9;
+        }
+        if (first) {
+            return "perf counters unavailable";
+        }
+        return out.str();
+    }
+
+}// namespace ReversiEngine
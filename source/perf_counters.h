@@ -0,0 +1,55 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+namespace ReversiEngine {
+
+    // Hardware counters of the calling thread read through Linux perf_event_open. Counters the
+    // kernel or the CPU refuses to open stay unavailable and read as zero; on other platforms
+    // nothing is available.
+    class PerfCounters {
+    public:
+        enum Event {
+            Cycles,
+            Instructions,
+            BranchMisses,
+            L1DataMisses,
+            LastLevelMisses,
+            DataTlbMisses,
+            Count
+        };
+
+        struct Values {
+            std::array<double, Event::Count> counts{};
+            std::array<bool, Event::Count> available{};
+
+            Values& operator+=(const Values& other);
+
+            // Per-node and per-second ratios, e.g. for printing next to nodes/sec.
+            [[nodiscard]] std::string Format(int64_t nodes, double seconds) const;
+        };
+
+        PerfCounters();
+
+        ~PerfCounters();
+
+        PerfCounters(const PerfCounters&) = delete;
+
+        PerfCounters& operator=(const PerfCounters&) = delete;
+
+        [[nodiscard]] bool Available() const;
+
+        void Start();
+
+        void Stop();
+
+        // Counts accumulated between all Start/Stop pairs, scaled for multiplexing.
+        [[nodiscard]] Values Read() const;
+
+    private:
+        std::array<int, Event::Count> descriptors_{};
+    };
+
+}// namespace ReversiEngine
@@ -0,0 +1,194 @@
+#include "arguments.h"
+#include "board.h"
+#include "notation.h"
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+namespace ReversiEngine {
+
+    namespace {
+        // Leaf counts from the initial position. A pass is a ply of its own and a finished game
+        // is a leaf wherever it happens.
+        const std::array<uint64_t, 15> START_POSITION_COUNTS = {
+                1,       4,         12,         56,          244,          1396,
+                8200,    55092,     390216,     3005288,     24571284,     212258800,
+                1939886636, 18429641748, 184042084512};
+
+        struct PerftOptions {
+            bool bulk = true;
+        };
+
+        std::atomic<uint64_t> last_move_mismatches = 0;
+
+        void CheckMakeMoveLast(const Board& board, const Cell& cell) {
+            Board full = board.MakeMove(cell);
+            Board last = board.MakeMoveLast(cell);
+            if (full.DiscDifference() != last.DiscDifference() ||
+                full.FinalEvaluation() != last.FinalEvaluation()) {
+                ++last_move_mismatches;
+            }
+        }
+
+        uint64_t Perft(const Board& board, int32_t depth, bool passed,
+                       const PerftOptions& options) {
+            if (depth == 0) {
+                return 1;
+            }
+            Bitset64 mask = board.PossibleMovesMask();
+            if (mask.value == 0) {
+                if (passed) {
+                    return 1;
+                }
+                return Perft(board.MakeMove(Cell{-1, -1}), depth - 1, true, options);
+            }
+            if (depth == 1 && options.bulk) {
+                return std::popcount(mask.value);
+            }
+            uint64_t result = 0;
+            for (size_t position = mask._Find_first(); position < 64;
+                 position = mask._Find_next(position)) {
+                Cell cell{static_cast<int32_t>(position >> 3), static_cast<int32_t>(position & 7)};
+                if (depth == 1) {
+                    CheckMakeMoveLast(board, cell);
+                    ++result;
+                } else {
+                    result += Perft(board.MakeMove(cell), depth - 1, false, options);
+                }
+            }
+            return result;
+        }
+
+        struct Task {
+            Board board;
+            int32_t depth;
+            bool passed;
+        };
+
+        // Expands the tree `plies` deep so that the threads get independent subtrees. Leaves
+        // reached while splitting are counted directly.
+        uint64_t Split(const Board& board, int32_t depth, bool passed, int32_t plies,
+                       std::vector<Task>& tasks) {
+            if (depth <= 1 || plies == 0) {
+                tasks.push_back({board, depth, passed});
+                return 0;
+            }
+            Bitset64 mask = board.PossibleMovesMask();
+            if (mask.value == 0) {
+                if (passed) {
+                    return 1;
+                }
+                return Split(board.MakeMove(Cell{-1, -1}), depth - 1, true, plies - 1, tasks);
+            }
+            uint64_t result = 0;
+            for (size_t position = mask._Find_first(); position < 64;
+                 position = mask._Find_next(position)) {
+                Cell cell{static_cast<int32_t>(position >> 3), static_cast<int32_t>(position & 7)};
+                result += Split(board.MakeMove(cell), depth - 1, false, plies - 1, tasks);
+            }
+            return result;
+        }
+
+        uint64_t ParallelPerft(const Board& board, int32_t depth, int32_t threads,
+                               const PerftOptions& options) {
+            if (threads <= 1) {
+                return Perft(board, depth, false, options);
+            }
+            std::vector<Task> tasks;
+            std::atomic<uint64_t> result = Split(board, depth, false, 3, tasks);
+            std::atomic<size_t> next_task = 0;
+            auto worker = [&]() {
+                uint64_t local = 0;
+                for (size_t i = next_task++; i < tasks.size(); i = next_task++) {
+                    local += Perft(tasks[i].board, tasks[i].depth, tasks[i].passed, options);
+                }
+                result += local;
+            };
+            std::vector<std::jthread> workers;
+            for (int32_t i = 0; i < threads; ++i) {
+                workers.emplace_back(worker);
+            }
+            workers.clear();
+            return result;
+        }
+
+        void Divide(const Board& board, int32_t depth, const PerftOptions& options) {
+            auto moves = board.PossibleMoves();
+            if (moves.empty()) {
+                moves.push_back(Cell{-1, -1});
+            }
+            for (const auto& cell : moves) {
+                std::cout << cell << ": "
+                          << Perft(board.MakeMove(cell), depth - 1, cell.row == -1, options)
+                          << std::endl;
+            }
+        }
+    }// namespace
+
+    int RunPerft(const Arguments& arguments) {
+        Board board;
+        board.InitPrecalc();
+        bool from_start = true;
+        if (arguments.Has("moves")) {
+            std::vector<Cell> moves;
+            if (!ParseMoves(arguments.GetString("moves", ""), moves, board)) {
+                std::cerr << "Illegal move sequence" << std::endl;
+                return 1;
+            }
+            from_start = moves.empty();
+        }
+        auto max_depth = static_cast<int32_t>(arguments.GetInt("depth", 9));
+        auto threads = static_cast<int32_t>(arguments.GetInt("threads", 1));
+        PerftOptions options;
+        // Without bulk counting every last-ply move is made, which also cross-checks
+        // MakeMoveLast against MakeMove.
+        options.bulk = !arguments.Has("no-bulk");
+
+        std::cout << board << std::endl;
+        if (arguments.Has("divide")) {
+            Divide(board, max_depth, options);
+            return 0;
+        }
+        bool ok = true;
+        for (int32_t depth = arguments.Has("single") ? max_depth : 1; depth <= max_depth;
+             ++depth) {
+            auto start = std::chrono::steady_clock::now();
+            uint64_t nodes = ParallelPerft(board, depth, threads, options);
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            auto nodes_per_sec =
+                    static_cast<int64_t>(static_cast<double>(nodes) / elapsed.count());
+            std::cout << "perft(" << depth << ") = " << nodes << " (" << elapsed.count()
+                      << " sec, " << nodes_per_sec << " nodes/sec)";
+            if (from_start && static_cast<size_t>(depth) < START_POSITION_COUNTS.size()) {
+                bool matches = nodes == START_POSITION_COUNTS[depth];
+                ok = ok && matches;
+                std::cout << (matches ? " OK" : " MISMATCH, expected ");
+                if (!matches) {
+                    std::cout << START_POSITION_COUNTS[depth];
+                }
+            }
+            std::cout << std::endl;
+        }
+        if (last_move_mismatches > 0) {
+            std::cout << "MakeMoveLast differs from MakeMove in " << last_move_mismatches
+                      << " positions" << std::endl;
+            ok = false;
+        }
+        return ok ? 0 : 1;
+    }
+
+}// namespace ReversiEngine
+
+int main(int argc, char** argv) {
+    ReversiEngine::Arguments arguments(argc, argv);
+    if (arguments.Has("help")) {
+        std::cout << "Usage: reversi-perft [--depth=N] [--moves=f5d6...] [--threads=N] [--single]\n"
+                     "                     [--divide] [--no-bulk]\n"
+                     "Counts leaf nodes and checks the start position against reference counts."
+                  << std::endl;
+        return 0;
+    }
+    return ReversiEngine::RunPerft(arguments);
+}
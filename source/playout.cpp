@@ -0,0 +1,120 @@
+#include "playout.h"
+#include "geometry.h"
+
+#include <array>
+#include <bit>
+
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
+
+namespace ReversiEngine {
+
+    namespace {
+        // Number of games one PlayoutBatch call keeps in flight.
+        constexpr size_t LANES = 8;
+
+        // A uniformly random set bit of a non-empty mask.
+        inline int32_t RandomSquare(uint64_t moves, Xorshift64& random) {
+            uint32_t index = random.Below(static_cast<uint32_t>(std::popcount(moves)));
+#ifdef __BMI2__
+            return std::countr_zero(_pdep_u64(uint64_t{1} << index, moves));
+#else
+            for (uint32_t i = 0; i < index; ++i) {
+                moves &= moves - 1;
+            }
+            return std::countr_zero(moves);
+#endif
+        }
+
+        // Final score for the side to move, empty squares to the winner.
+        inline int32_t FinalScore(uint64_t own, uint64_t opponent) {
+            int32_t difference = std::popcount(own) - std::popcount(opponent);
+            int32_t empties = 64 - std::popcount(own | opponent);
+            return difference > 0 ? difference + empties
+                                  : difference < 0 ? difference - empties : 0;
+        }
+
+        // State of one game of a batch. `sign` is +1 while the original side is to move. Every
+        // lane has its own generator so that the lanes do not wait for each other.
+        struct Lane {
+            uint64_t own = 0;
+            uint64_t opponent = 0;
+            int32_t sign = 1;
+            bool passed = false;
+            size_t game = 0;
+            bool active = false;
+            Xorshift64 random{1};
+        };
+
+        // Plays one ply; returns false when the game is over.
+        inline bool Advance(uint64_t& own, uint64_t& opponent, int32_t& sign, bool& passed,
+                            Xorshift64& random) {
+            uint64_t moves = PlayoutMoves(own, opponent);
+            if (moves == 0) {
+                if (passed) {
+                    return false;
+                }
+                passed = true;
+            } else {
+                passed = false;
+                int32_t square = RandomSquare(moves, random);
+                uint64_t flips = PlayoutFlips(own, opponent, square);
+                own |= flips | (uint64_t{1} << square);
+                opponent ^= flips;
+            }
+            std::swap(own, opponent);
+            sign = -sign;
+            return true;
+        }
+    }// namespace
+
+    uint64_t PlayoutMoves(uint64_t own, uint64_t opponent) {
+        return Geometry<8>::Moves(own, opponent);
+    }
+
+    uint64_t PlayoutFlips(uint64_t own, uint64_t opponent, int32_t square) {
+        return Geometry<8>::Flips(own, opponent, square);
+    }
+
+    int32_t Playout(PlayoutPosition position, Xorshift64& random) {
+        int32_t sign = 1;
+        bool passed = false;
+        while (Advance(position.own, position.opponent, sign, passed, random)) {
+        }
+        return sign * FinalScore(position.own, position.opponent);
+    }
+
+    void PlayoutBatch(const PlayoutPosition* positions, int32_t* results, size_t count,
+                      Xorshift64& random) {
+        std::array<Lane, LANES> lanes;
+        size_t next = 0;
+        size_t active = 0;
+        auto start = [&](Lane& lane) {
+            lane.active = next < count;
+            if (lane.active) {
+                lane.own = positions[next].own;
+                lane.opponent = positions[next].opponent;
+                lane.sign = 1;
+                lane.passed = false;
+                lane.game = next++;
+                ++active;
+            }
+        };
+        for (auto& lane : lanes) {
+            lane.random = Xorshift64(random.Next());
+            start(lane);
+        }
+        while (active > 0) {
+            for (auto& lane : lanes) {
+                if (lane.active &&
+                    !Advance(lane.own, lane.opponent, lane.sign, lane.passed, lane.random)) {
+                    results[lane.game] = lane.sign * FinalScore(lane.own, lane.opponent);
+                    --active;
+                    start(lane);
+                }
+            }
+        }
+    }
+
+}// namespace ReversiEngine
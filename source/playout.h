@@ -0,0 +1,62 @@
+#pragma once
+
+#include "board.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ReversiEngine {
+
+    // xorshift64* generator: a few cycles per number, good enough to pick playout moves.
+    class Xorshift64 {
+    public:
+        explicit Xorshift64(uint64_t seed) : state_(seed ? seed : 0x9E3779B97F4A7C15ULL) {
+        }
+
+        uint64_t Next() {
+            state_ ^= state_ >> 12;
+            state_ ^= state_ << 25;
+            state_ ^= state_ >> 27;
+            return state_ * 0x2545F4914F6CDD1DULL;
+        }
+
+        // Uniform in [0, bound) by multiply-shift instead of a division.
+        uint32_t Below(uint32_t bound) {
+            return static_cast<uint32_t>(((Next() >> 32) * bound) >> 32);
+        }
+
+    private:
+        uint64_t state_;
+    };
+
+    // A position as the discs of the side to move and of its opponent.
+    struct PlayoutPosition {
+        uint64_t own = 0;
+        uint64_t opponent = 0;
+
+        PlayoutPosition() = default;
+
+        PlayoutPosition(uint64_t own, uint64_t opponent) : own(own), opponent(opponent) {
+        }
+
+        explicit PlayoutPosition(const Board& board)
+            : own(board.OwnDiscs().to_ullong()), opponent(board.OpponentDiscs().to_ullong()) {
+        }
+    };
+
+    // Legal moves of the side to move, computed with shifts on the two bitboards only.
+    [[nodiscard]] uint64_t PlayoutMoves(uint64_t own, uint64_t opponent);
+
+    // Discs flipped by the side to move playing on `square`.
+    [[nodiscard]] uint64_t PlayoutFlips(uint64_t own, uint64_t opponent, int32_t square);
+
+    // Plays uniformly random moves to the end of the game and returns the final disc
+    // difference (empty squares to the winner) for the side to move in `position`.
+    [[nodiscard]] int32_t Playout(PlayoutPosition position, Xorshift64& random);
+
+    // Plays one random game from each position, several games interleaved so that their
+    // dependency chains overlap, and writes the results as Playout does.
+    void PlayoutBatch(const PlayoutPosition* positions, int32_t* results, size_t count,
+                      Xorshift64& random);
+
+}// namespace ReversiEngine
@@ -0,0 +1,64 @@
+#include "search_stats.h"
+
+#include <iomanip>
+#include <sstream>
+
+namespace ReversiEngine {
+
+    void SearchStats::Reset() {
+        *this = SearchStats();
+    }
+
+    double SearchStats::EffectiveBranchingFactor() const {
+        if (iterations.size() < 2 || iterations[iterations.size() - 2].nodes == 0) {
+            return 0;
+        }
+        return static_cast<double>(iterations.back().nodes) /
+               static_cast<double>(iterations[iterations.size() - 2].nodes);
+    }
+
+    std::string SearchStats::ToJson() const {
+        int64_t nodes = 0;
+        double seconds = 0;
+        for (const auto& iteration : iterations) {
+            nodes += iteration.nodes;
+            seconds += iteration.seconds;
+        }
+        std::ostringstream out;
+        out << std::fixed << std::setprecision(6);
+        out << "{\"depth\": " << (iterations.empty() ? 0 : iterations.back().depth)
+            << ", \"nodes\": " << nodes << ", \"seconds\": " << seconds
+            << ", \"nodes_per_sec\": "
+            << (seconds > 0 ? static_cast<int64_t>(static_cast<double>(nodes) / seconds) : 0)
+            << ", \"effective_branching_factor\": " << EffectiveBranchingFactor()
+            << ", \"evaluation_cache_hits\": " << evaluation_cache_hits
+            << ", \"evaluation_cache_misses\": " << evaluation_cache_misses;
+#ifdef REVERSI_SEARCH_STATS
+        out << ", \"interior_nodes\": " << interior_nodes << ", \"leaf_nodes\": " << leaf_nodes
+            << ", \"beta_cutoffs\": " << beta_cutoffs
+            << ", \"first_move_cutoff_rate\": "
+            << (beta_cutoffs > 0 ? static_cast<double>(first_move_cutoffs) /
+                                           static_cast<double>(beta_cutoffs)
+                                 : 0)
+            << ", \"table_probes\": " << table_probes << ", \"table_hits\": " << table_hits
+            << ", \"table_cutoffs\": " << table_cutoffs << ", \"nodes_per_ply\": [";
+        int32_t last_ply = MAX_PLY;
+        while (last_ply > 0 && nodes_per_ply[last_ply] == 0) {
+            --last_ply;
+        }
+        for (int32_t ply = 0; ply <= last_ply; ++ply) {
+            out << (ply == 0 ? "" : ", ") << nodes_per_ply[ply];
+        }
+        out << "]";
+#endif
+        out << ", \"iterations\": [";
+        for (size_t i = 0; i < iterations.size(); ++i) {
+            out << (i == 0 ? "" : ", ") << "{\"depth\": " << iterations[i].depth
+                << ", \"nodes\": " << iterations[i].nodes
+                << ", \"seconds\": " << iterations[i].seconds << "}";
+        }
+        out << "]}";
+        return out.str();
+    }
+
+}// namespace ReversiEngine
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Detailed counters are only collected when the SEARCH_STATS build option is on; without it the
+// statements disappear and only the node count and the per-iteration timings remain.
+#ifdef REVERSI_SEARCH_STATS
+#define SEARCH_STATS(statement) statement
+#else
+#define SEARCH_STATS(statement)
+#endif
+
+namespace ReversiEngine {
+
+    // Statistics of one search. Every Engine owns its own instance, so threads never share
+    // counters.
+    struct SearchStats {
+        static constexpr int32_t MAX_PLY = 64;
+
+        struct Iteration {
+            int32_t depth = 0;
+            int64_t nodes = 0;
+            double seconds = 0;
+        };
+
+        // Plies 0 to MAX_PLY: a search to the greatest depth has its leaves at ply MAX_PLY.
+        std::array<int64_t, MAX_PLY + 1> nodes_per_ply{};
+        int64_t interior_nodes = 0;
+        int64_t leaf_nodes = 0;
+        int64_t beta_cutoffs = 0;
+        int64_t first_move_cutoffs = 0;
+        int64_t table_probes = 0;
+        int64_t table_hits = 0;
+        int64_t table_cutoffs = 0;
+        // Of the engine's evaluation cache; counted in every build.
+        int64_t evaluation_cache_hits = 0;
+        int64_t evaluation_cache_misses = 0;
+        std::vector<Iteration> iterations;
+
+        void Reset();
+
+        inline void OnInteriorNode(int32_t ply) {
+            ++interior_nodes;
+            ++nodes_per_ply[ply];
+        }
+
+        inline void OnLeafNode(int32_t ply) {
+            ++leaf_nodes;
+            ++nodes_per_ply[ply];
+        }
+
+        inline void OnCutoff(bool first_move) {
+            ++beta_cutoffs;
+            first_move_cutoffs += first_move;
+        }
+
+        inline void OnTableProbe(bool hit, bool cutoff) {
+            ++table_probes;
+            table_hits += hit;
+            table_cutoffs += cutoff;
+        }
+
+        // Ratio of the node counts of the last two completed iterations.
+        [[nodiscard]] double EffectiveBranchingFactor() const;
+
+        [[nodiscard]] std::string ToJson() const;
+    };
+
+}// namespace ReversiEngine
@@ -0,0 +1,116 @@
+#include "search_trace.h"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+namespace ReversiEngine {
+
+    namespace {
+        // The first record of a file.
+        const char TRACE_MAGIC[sizeof(TraceRecord)] = "REVERSI TRACE 2";
+
+        // How often the flush thread empties the buffers.
+        const std::chrono::milliseconds FLUSH_INTERVAL(20);
+
+        std::atomic<uint32_t> next_search{1};
+    }// namespace
+
+    TraceBuffer::TraceBuffer(size_t capacity, double sample_rate, uint64_t seed)
+        : records_(std::bit_ceil(std::max<size_t>(capacity, 2))), mask_(records_.size() - 1),
+          sample_threshold_(sample_rate >= 1 ? ~uint64_t{0}
+                                             : static_cast<uint64_t>(
+                                                       std::ldexp(std::max(sample_rate, 0.0), 64))),
+          random_(seed | 1) {
+    }
+
+    bool TraceBuffer::Sample() {
+        random_ ^= random_ << 13;
+        random_ ^= random_ >> 7;
+        random_ ^= random_ << 17;
+        return random_ < sample_threshold_ || sample_threshold_ == ~uint64_t{0};
+    }
+
+    void TraceBuffer::Drain(std::FILE* file) {
+        uint64_t tail = tail_.load(std::memory_order_relaxed);
+        uint64_t head = head_.load(std::memory_order_acquire);
+        while (tail != head) {
+            uint64_t start = tail & mask_;
+            uint64_t count = std::min(head - tail, records_.size() - start);
+            std::fwrite(&records_[start], sizeof(TraceRecord), count, file);
+            tail += count;
+        }
+        tail_.store(tail, std::memory_order_release);
+    }
+
+    SearchTracer::SearchTracer(const std::string& path, double sample_rate, size_t buffer_records)
+        : file_(std::fopen(path.c_str(), "wb")), sample_rate_(sample_rate),
+          buffer_records_(buffer_records) {
+        if (!file_) {
+            return;
+        }
+        std::fwrite(TRACE_MAGIC, sizeof(TRACE_MAGIC), 1, file_);
+        flusher_ = std::thread([this]() {
+            std::unique_lock lock(mutex_);
+            while (!closing_) {
+                wake_.wait_for(lock, FLUSH_INTERVAL);
+                Flush();
+            }
+        });
+    }
+
+    SearchTracer::~SearchTracer() {
+        if (!file_) {
+            return;
+        }
+        {
+            std::lock_guard lock(mutex_);
+            closing_ = true;
+        }
+        wake_.notify_one();
+        flusher_.join();
+        Flush();
+        std::fclose(file_);
+    }
+
+    bool SearchTracer::IsOpen() const {
+        return file_ != nullptr;
+    }
+
+    TraceBuffer* SearchTracer::CreateBuffer() {
+        std::lock_guard lock(mutex_);
+        buffers_.push_back(std::make_unique<TraceBuffer>(
+                buffer_records_, sample_rate_, 0x9E3779B97F4A7C15ULL * (buffers_.size() + 1)));
+        return buffers_.back().get();
+    }
+
+    uint32_t SearchTracer::NextSearch() {
+        return next_search++;
+    }
+
+    void SearchTracer::Flush() {
+        for (auto& buffer : buffers_) {
+            buffer->Drain(file_);
+        }
+        std::fflush(file_);
+    }
+
+    bool ReadTrace(const std::string& path, std::vector<TraceRecord>& records) {
+        std::FILE* file = std::fopen(path.c_str(), "rb");
+        if (!file) {
+            return false;
+        }
+        char magic[sizeof(TRACE_MAGIC)];
+        bool valid = std::fread(magic, sizeof(magic), 1, file) == 1 &&
+                     std::memcmp(magic, TRACE_MAGIC, sizeof(magic)) == 0;
+        TraceRecord record;
+        while (valid && std::fread(&record, sizeof(record), 1, file) == 1) {
+            records.push_back(record);
+        }
+        std::fclose(file);
+        return valid;
+    }
+
+}// namespace ReversiEngine
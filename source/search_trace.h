@@ -0,0 +1,148 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ReversiEngine {
+
+    // One event of a traced search in 16 bytes. Nodes are recorded when they return, so the
+    // records of a search are its tree in post-order: the children of a node at ply p are the
+    // records at ply p + 1 since the previous record at ply p or less.
+    struct TraceRecord {
+        enum Kind : uint8_t {
+            Node,
+            // A new search. It and the Root record of the same search each hold half of the root
+            // position as a PackedPosition, in place of the node fields.
+            Search,
+            Root,
+        };
+
+        enum Flags : uint8_t {
+            TableCutoff = 1,
+            // The search was stopped and the score is meaningless.
+            Stopped = 2,
+            // Records before this one were dropped because the buffer was full.
+            AfterGap = 4,
+        };
+
+        uint32_t search = 0;
+        Kind kind = Node;
+        uint8_t ply = 0;
+        uint8_t depth = 0;// remaining depth
+        int8_t move = -1; // square that led to the node, -1 for a pass or the root
+        int16_t alpha = 0;
+        int16_t beta = 0;
+        int16_t score = 0;
+        uint8_t flags = 0;
+        uint8_t reserved = 0;
+
+        // Bytes of the root position held by a Search or Root record.
+        static constexpr size_t ROOT_BYTES = 8;
+
+        // Those bytes, from `depth` through `score`.
+        [[nodiscard]] uint8_t* RootBytes() {
+            return reinterpret_cast<uint8_t*>(this) + offsetof(TraceRecord, depth);
+        }
+
+        [[nodiscard]] const uint8_t* RootBytes() const {
+            return reinterpret_cast<const uint8_t*>(this) + offsetof(TraceRecord, depth);
+        }
+    };
+
+    static_assert(sizeof(TraceRecord) == 16);
+    static_assert(offsetof(TraceRecord, score) + sizeof(int16_t) -
+                          offsetof(TraceRecord, depth) == TraceRecord::ROOT_BYTES);
+
+    // Ring of records written by one search thread and read by the tracer's flush thread.
+    // Push never blocks: records that do not fit are dropped and the next one is marked.
+    class TraceBuffer {
+    public:
+        explicit TraceBuffer(size_t capacity, double sample_rate, uint64_t seed);
+
+        void Push(const TraceRecord& record) {
+            Push(&record, 1);
+        }
+
+        // Pushes all of `records` or, if they do not all fit, none of them.
+        void Push(const TraceRecord* records, size_t count) {
+            uint64_t head = head_.load(std::memory_order_relaxed);
+            if (records_.size() - (head - tail_.load(std::memory_order_acquire)) < count) {
+                gap_ = true;
+                return;
+            }
+            for (size_t i = 0; i < count; ++i) {
+                TraceRecord& slot = records_[(head + i) & mask_];
+                slot = records[i];
+                if (gap_) {
+                    slot.flags |= TraceRecord::AfterGap;
+                    gap_ = false;
+                }
+            }
+            head_.store(head + count, std::memory_order_release);
+        }
+
+        // Whether to trace the next search, at the tracer's sampling rate.
+        [[nodiscard]] bool Sample();
+
+    private:
+        friend class SearchTracer;
+
+        // Writes the records pushed so far; called by the flush thread only.
+        void Drain(std::FILE* file);
+
+        std::vector<TraceRecord> records_;
+        uint64_t mask_;
+        std::atomic<uint64_t> head_{0};
+        std::atomic<uint64_t> tail_{0};
+        bool gap_ = false;
+        uint64_t sample_threshold_;
+        uint64_t random_;
+    };
+
+    // Writes the records of its buffers to a file from a background thread. Engines trace only
+    // when given a buffer (Engine::trace), one buffer per engine.
+    class SearchTracer {
+    public:
+        // Traces a `sample_rate` fraction of the searches.
+        SearchTracer(const std::string& path, double sample_rate, size_t buffer_records = 1 << 16);
+
+        // Writes the remaining records.
+        ~SearchTracer();
+
+        SearchTracer(const SearchTracer&) = delete;
+
+        SearchTracer& operator=(const SearchTracer&) = delete;
+
+        [[nodiscard]] bool IsOpen() const;
+
+        // A new buffer for one engine, owned by the tracer.
+        [[nodiscard]] TraceBuffer* CreateBuffer();
+
+        // Identifier of a new traced search, unique within the file.
+        [[nodiscard]] static uint32_t NextSearch();
+
+    private:
+        void Flush();
+
+        std::FILE* file_ = nullptr;
+        double sample_rate_;
+        size_t buffer_records_;
+        std::mutex mutex_;
+        std::condition_variable wake_;
+        bool closing_ = false;
+        std::vector<std::unique_ptr<TraceBuffer>> buffers_;
+        std::thread flusher_;
+    };
+
+    // Reads all records of a trace file.
+    [[nodiscard]] bool ReadTrace(const std::string& path, std::vector<TraceRecord>& records);
+
+}// namespace ReversiEngine
@@ -0,0 +1,233 @@
+#include "small_board.h"
+#include "stability.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ReversiEngine {
+
+    namespace {
+        // Larger than any final score on a board of up to 64 squares.
+        const int32_t SCORE_BOUND = 100;
+
+        // Positions with fewer empty squares are neither stored in the table nor sorted.
+        const int32_t TABLE_EMPTIES = 6;
+        const int32_t SORT_EMPTIES = 6;
+        // Closer to the end the stability bound costs more than the nodes it saves.
+        const int32_t STABILITY_EMPTIES = 3;
+
+        template<int32_t Size>
+        int32_t FinalScore(uint64_t own, uint64_t opponent) {
+            int32_t difference = std::popcount(own) - std::popcount(opponent);
+            int32_t empties = Geometry<Size>::SQUARES - std::popcount(own | opponent);
+            return difference > 0 ? difference + empties
+                                  : difference < 0 ? difference - empties : 0;
+        }
+
+        template<int32_t Size>
+        constexpr uint64_t CORNERS = Geometry<Size>::Bit(0, 0) | Geometry<Size>::Bit(0, Size - 1) |
+                                     Geometry<Size>::Bit(Size - 1, 0) |
+                                     Geometry<Size>::Bit(Size - 1, Size - 1);
+
+        struct Child {
+            uint64_t own = 0;// discs of the side to move in the child, the opponent here
+            uint64_t opponent = 0;
+            int32_t square = 0;
+            int32_t mobility = 0;
+        };
+
+        template<int32_t Size>
+        Child MakeChild(uint64_t own, uint64_t opponent, int32_t square) {
+            uint64_t flips = Geometry<Size>::Flips(own, opponent, square);
+            return {opponent ^ flips, own | flips | (uint64_t{1} << square), square, 0};
+        }
+    }// namespace
+
+    template<int32_t Size>
+    void SmallPosition<Size>::Play(int32_t square) {
+        if (square >= 0) {
+            uint64_t flips = Geometry<Size>::Flips(own, opponent, square);
+            own |= flips | (uint64_t{1} << square);
+            opponent ^= flips;
+        }
+        std::swap(own, opponent);
+        first_to_move = !first_to_move;
+    }
+
+    template<int32_t Size>
+    bool SmallPosition<Size>::PlayMoves(std::string_view moves) {
+        for (size_t i = 0; i + 1 < moves.size(); i += 2) {
+            int32_t col = moves[i] - 'a';
+            int32_t row = moves[i + 1] - '1';
+            if (col < 0 || col >= Size || row < 0 || row >= Size) {
+                return false;
+            }
+            if (Moves() == 0) {
+                Play(-1);
+            }
+            if (!(Moves() & Geometry<Size>::Bit(row, col))) {
+                return false;
+            }
+            Play(Geometry<Size>::Square(row, col));
+        }
+        return moves.size() % 2 == 0;
+    }
+
+    template<int32_t Size>
+    int32_t SmallBoardSolver<Size>::Search(uint64_t own, uint64_t opponent, int32_t alpha,
+                                           int32_t beta, bool passed, int64_t& nodes) {
+        ++nodes;
+        uint64_t moves = Geometry<Size>::Moves(own, opponent);
+        if (moves == 0) {
+            if (passed) {
+                return FinalScore<Size>(own, opponent);
+            }
+            return -Search(opponent, own, -beta, -alpha, true, nodes);
+        }
+        int32_t empties = Geometry<Size>::SQUARES - std::popcount(own | opponent);
+        if (empties == 1) {
+            Child child = MakeChild<Size>(own, opponent, std::countr_zero(moves));
+            return -FinalScore<Size>(child.own, child.opponent);
+        }
+        // The opponent's stable discs cap the score the side to move can still reach.
+        if (empties >= STABILITY_EMPTIES &&
+            alpha >= Geometry<Size>::SQUARES - 2 * std::popcount(opponent)) {
+            int32_t bound =
+                    Geometry<Size>::SQUARES - 2 * std::popcount(StableDiscs<Size>(opponent, own));
+            if (bound <= alpha) {
+                return bound;
+            }
+        }
+
+        uint64_t key = 0;
+        uint8_t table_move = TranspositionTable::NO_MOVE;
+        if (empties >= TABLE_EMPTIES) {
+            key = PositionHash(own, opponent);
+            TranspositionTable::Entry entry;
+            if (table_.Probe(key, entry)) {
+                if (entry.bound == TranspositionTable::Exact ||
+                    (entry.bound == TranspositionTable::Lower && entry.score >= beta) ||
+                    (entry.bound == TranspositionTable::Upper && entry.score <= alpha)) {
+                    return entry.score;
+                }
+                table_move = entry.move;
+            }
+        }
+
+        std::array<Child, Geometry<Size>::SQUARES> children;
+        int32_t count = 0;
+        for (; moves; moves &= moves - 1) {
+            children[count++] = MakeChild<Size>(own, opponent, std::countr_zero(moves));
+        }
+        if (empties >= SORT_EMPTIES) {
+            // Fastest first: the moves that leave the opponent the fewest replies, corners
+            // counting double, after the best move stored in the table.
+            for (int32_t i = 0; i < count; ++i) {
+                Child& child = children[i];
+                uint64_t replies = Geometry<Size>::Moves(child.own, child.opponent);
+                child.mobility = child.square == table_move
+                                         ? -1
+                                         : std::popcount(replies) +
+                                                   std::popcount(replies & CORNERS<Size>);
+            }
+            std::sort(children.begin(), children.begin() + count,
+                      [](const Child& lhs, const Child& rhs) {
+                          return lhs.mobility < rhs.mobility;
+                      });
+        }
+
+        int32_t original_alpha = alpha;
+        int32_t value = -SCORE_BOUND;
+        int32_t best = children[0].square;
+        for (int32_t i = 0; i < count; ++i) {
+            const Child& child = children[i];
+            // Principal variation search: the moves after the first are only proven worse with
+            // a null window and searched again if that fails.
+            int32_t candidate_value;
+            if (i == 0) {
+                candidate_value = -Search(child.own, child.opponent, -beta, -alpha, false, nodes);
+            } else {
+                candidate_value =
+                        -Search(child.own, child.opponent, -alpha - 1, -alpha, false, nodes);
+                if (candidate_value > alpha && candidate_value < beta) {
+                    candidate_value = -Search(child.own, child.opponent, -beta, -candidate_value,
+                                              false, nodes);
+                }
+            }
+            if (candidate_value > value) {
+                value = candidate_value;
+                best = child.square;
+            }
+            if (value >= beta) {
+                break;
+            }
+            alpha = std::max(alpha, value);
+        }
+        if (empties >= TABLE_EMPTIES) {
+            TranspositionTable::Bound bound = value >= beta            ? TranspositionTable::Lower
+                                              : value <= original_alpha ? TranspositionTable::Upper
+                                                                        : TranspositionTable::Exact;
+            table_.Store(key, {static_cast<int16_t>(value), static_cast<uint8_t>(empties), bound,
+                               static_cast<uint8_t>(best)});
+        }
+        return value;
+    }
+
+    template<int32_t Size>
+    typename SmallBoardSolver<Size>::Result
+    SmallBoardSolver<Size>::Solve(const SmallPosition<Size>& position, int32_t threads) {
+        Result result;
+        uint64_t moves = position.Moves();
+        if (moves == 0) {
+            result.score = Search(position.own, position.opponent, -SCORE_BOUND, SCORE_BOUND,
+                                  false, result.nodes);
+            return result;
+        }
+        std::vector<int32_t> squares;
+        for (; moves; moves &= moves - 1) {
+            squares.push_back(std::countr_zero(moves));
+        }
+        // A root move only needs an exact score if it beats the best one finished so far; a
+        // stale bound just makes a search wider than necessary.
+        result.score = -SCORE_BOUND;
+        result.move = squares.front();
+        std::atomic<size_t> next_move = 0;
+        std::mutex mutex;
+        auto worker = [&]() {
+            int64_t nodes = 0;
+            for (size_t i = next_move++; i < squares.size(); i = next_move++) {
+                int32_t alpha;
+                {
+                    std::lock_guard lock(mutex);
+                    alpha = result.score;
+                }
+                Child child = MakeChild<Size>(position.own, position.opponent, squares[i]);
+                int32_t value =
+                        -Search(child.own, child.opponent, -SCORE_BOUND, -alpha, false, nodes);
+                std::lock_guard lock(mutex);
+                if (value > result.score) {
+                    result.score = value;
+                    result.move = squares[i];
+                }
+            }
+            std::lock_guard lock(mutex);
+            result.nodes += nodes;
+        };
+        std::vector<std::jthread> workers;
+        for (int32_t i = 0; i < std::max(threads, 1); ++i) {
+            workers.emplace_back(worker);
+        }
+        workers.clear();
+        return result;
+    }
+
+    template struct SmallPosition<4>;
+    template struct SmallPosition<6>;
+    template class SmallBoardSolver<4>;
+    template class SmallBoardSolver<6>;
+
+}// namespace ReversiEngine
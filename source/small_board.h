@@ -0,0 +1,80 @@
+#pragma once
+
+#include "geometry.h"
+#include "transposition_table.h"
+
+#include <cstdint>
+#include <iostream>
+#include <string_view>
+
+namespace ReversiEngine {
+
+    // Position on a Size x Size board as the discs of the side to move and of its opponent.
+    template<int32_t Size>
+    struct SmallPosition {
+        uint64_t own = Geometry<Size>::INITIAL_FIRST;
+        uint64_t opponent = Geometry<Size>::INITIAL_SECOND;
+        // Player to move: true for the first player (x).
+        bool first_to_move = true;
+
+        [[nodiscard]] uint64_t Moves() const {
+            return Geometry<Size>::Moves(own, opponent);
+        }
+
+        // Plays a legal move; square -1 passes.
+        void Play(int32_t square);
+
+        // Parses moves such as "c1d3" (column letter, row number), passing automatically when
+        // the side to move has no legal move. Returns false at the first illegal move.
+        [[nodiscard]] bool PlayMoves(std::string_view moves);
+
+        friend std::ostream& operator<<(std::ostream& os, const SmallPosition& position) {
+            uint64_t first = position.first_to_move ? position.own : position.opponent;
+            uint64_t second = position.first_to_move ? position.opponent : position.own;
+            for (int32_t row = Size - 1; row >= 0; --row) {
+                os << static_cast<char>('1' + row) << ' ';
+                for (int32_t col = 0; col < Size; ++col) {
+                    uint64_t bit = Geometry<Size>::Bit(row, col);
+                    os << (first & bit ? 'x' : second & bit ? 'o' : '*') << ' ';
+                }
+                os << "\n";
+            }
+            os << "  ";
+            for (int32_t col = 0; col < Size; ++col) {
+                os << static_cast<char>('a' + col) << ' ';
+            }
+            return os;
+        }
+    };
+
+    // Exact solver for small boards: alpha-beta to the end of the game with a transposition
+    // table and fastest-first move ordering. The root moves are split between threads, which
+    // share the table and the best score so far.
+    template<int32_t Size>
+    class SmallBoardSolver {
+    public:
+        struct Result {
+            // Final disc difference for the side to move, empty squares to the winner.
+            int32_t score = 0;
+            int32_t move = -1;// square of a best move, -1 to pass
+            int64_t nodes = 0;
+        };
+
+        explicit SmallBoardSolver(size_t hash_megabytes) : table_(hash_megabytes) {
+        }
+
+        [[nodiscard]] Result Solve(const SmallPosition<Size>& position, int32_t threads);
+
+    private:
+        [[nodiscard]] int32_t Search(uint64_t own, uint64_t opponent, int32_t alpha, int32_t beta,
+                                     bool passed, int64_t& nodes);
+
+        TranspositionTable table_;
+    };
+
+    extern template struct SmallPosition<4>;
+    extern template struct SmallPosition<6>;
+    extern template class SmallBoardSolver<4>;
+    extern template class SmallBoardSolver<6>;
+
+}// namespace ReversiEngine
@@ -0,0 +1,58 @@
+#include "arguments.h"
+#include "small_board.h"
+
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+namespace ReversiEngine {
+
+    namespace {
+        template<int32_t Size>
+        int RunSolve(const Arguments& arguments) {
+            SmallPosition<Size> position;
+            if (!position.PlayMoves(arguments.GetString("moves", ""))) {
+                std::cerr << "Illegal moves: " << arguments.GetString("moves", "") << std::endl;
+                return 1;
+            }
+            auto threads = static_cast<int32_t>(arguments.GetInt(
+                    "threads", std::max(1u, std::thread::hardware_concurrency())));
+            SmallBoardSolver<Size> solver(static_cast<size_t>(arguments.GetInt("hash", 64)));
+            std::cout << position << "\n"
+                      << (position.first_to_move ? 'x' : 'o') << " to move" << std::endl;
+
+            auto start = std::chrono::steady_clock::now();
+            auto result = solver.Solve(position, threads);
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            std::cout << "Score: " << result.score << ", best move: ";
+            if (result.move < 0) {
+                std::cout << "Skip";
+            } else {
+                std::cout << static_cast<char>('a' + result.move % Size)
+                          << static_cast<char>('1' + result.move / Size);
+            }
+            std::cout << "\nSolved in " << elapsed.count() << " sec, " << result.nodes
+                      << " nodes ("
+                      << static_cast<int64_t>(static_cast<double>(result.nodes) /
+                                              std::max(elapsed.count(), 1e-9))
+                      << " nodes/sec)" << std::endl;
+            return 0;
+        }
+    }// namespace
+
+}// namespace ReversiEngine
+
+int main(int argc, char** argv) {
+    ReversiEngine::Arguments arguments(argc, argv);
+    int64_t size = arguments.GetInt("size", 6);
+    if (arguments.Has("help") || (size != 4 && size != 6)) {
+        std::cout << "Usage: reversi-solve [--size=4|6] [--moves=c4d3...] [--threads=N] "
+                     "[--hash=MB]\n"
+                     "Solves a small-board game exactly and prints the final disc difference\n"
+                     "for the side to move (empty squares to the winner) with a best move."
+                  << std::endl;
+        return arguments.Has("help") ? 0 : 1;
+    }
+    return size == 4 ? ReversiEngine::RunSolve<4>(arguments)
+                     : ReversiEngine::RunSolve<6>(arguments);
+}
@@ -0,0 +1,202 @@
+#include "stability.h"
+#include "geometry.h"
+
+#include <bit>
+#include <cstddef>
+#include <vector>
+
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
+
+namespace ReversiEngine {
+
+    namespace {
+        template<int32_t Size>
+        constexpr uint32_t LINE = (1u << Size) - 1;
+
+        // Bit 0 of every row.
+        template<int32_t Size>
+        constexpr uint64_t FIRST_COLUMN = [] {
+            uint64_t mask = 0;
+            for (int32_t row = 0; row < Size; ++row) {
+                mask |= Geometry<Size>::Bit(row, 0);
+            }
+            return mask;
+        }();
+
+        template<int32_t Size>
+        constexpr uint64_t LAST_ROW = uint64_t{LINE<Size>} << (Size * (Size - 1));
+
+        template<int32_t Shift>
+        uint64_t Step(uint64_t bits) {
+            if constexpr (Shift > 0) {
+                return bits << Shift;
+            } else {
+                return bits >> -Shift;
+            }
+        }
+
+        // Squares from which a line in the direction of Shift reaches an empty square: the
+        // empty squares spread along the line with steps of 1, 2 and 4 squares. `inside` are
+        // the squares a step may land on without having wrapped around the board.
+        template<int32_t Shift>
+        uint64_t EmptyRay(uint64_t empty, uint64_t inside) {
+            uint64_t ray = empty;
+            uint64_t through = inside;
+            ray |= through & Step<Shift>(ray);
+            through &= Step<Shift>(through);
+            ray |= through & Step<2 * Shift>(ray);
+            through &= Step<2 * Shift>(through);
+            ray |= through & Step<4 * Shift>(ray);
+            return ray;
+        }
+
+        // Squares whose line in the direction of Shift (both ways) has no empty square.
+        template<int32_t Shift>
+        uint64_t FullLines(uint64_t empty, uint64_t inside_forward, uint64_t inside_backward) {
+            return ~(EmptyRay<Shift>(empty, inside_forward) |
+                     EmptyRay<-Shift>(empty, inside_backward));
+        }
+
+        // Discs of `own` that stay own whatever is played on the empty squares of a line of
+        // Size squares; a move may go on any empty square, flipping if it flanks something.
+        template<int32_t Size>
+        uint32_t StableLine(uint32_t own, uint32_t opponent, std::vector<int16_t>& memo) {
+            int16_t& result = memo[(own << Size) | opponent];
+            if (result >= 0) {
+                return static_cast<uint32_t>(result);
+            }
+            uint32_t stable = own;
+            uint32_t empty = LINE<Size> & ~(own | opponent);
+            for (int32_t x = 0; x < Size && stable; ++x) {
+                if (!((empty >> x) & 1)) {
+                    continue;
+                }
+                for (int32_t mover = 0; mover < 2 && stable; ++mover) {
+                    uint32_t player = (mover == 0 ? own : opponent) | (1u << x);
+                    uint32_t other = mover == 0 ? opponent : own;
+                    for (int32_t direction : {-1, 1}) {
+                        int32_t y = x + direction;
+                        uint32_t flips = 0;
+                        while (y >= 0 && y < Size && ((other >> y) & 1)) {
+                            flips |= 1u << y;
+                            y += direction;
+                        }
+                        if (y >= 0 && y < Size && ((player >> y) & 1)) {
+                            player |= flips;
+                            other &= ~flips;
+                        }
+                    }
+                    stable &= mover == 0 ? StableLine<Size>(player, other, memo)
+                                         : StableLine<Size>(other, player, memo);
+                }
+            }
+            result = static_cast<int16_t>(stable);
+            return stable;
+        }
+
+        template<int32_t Size>
+        const std::vector<uint8_t>& EdgeTable() {
+            static const std::vector<uint8_t> table = [] {
+                std::vector<uint8_t> result(std::size_t{1} << (2 * Size));
+                std::vector<int16_t> memo(result.size(), -1);
+                for (uint32_t own = 0; own <= LINE<Size>; ++own) {
+                    for (uint32_t opponent = 0; opponent <= LINE<Size>; ++opponent) {
+                        if (!(own & opponent)) {
+                            result[(own << Size) | opponent] =
+                                    static_cast<uint8_t>(StableLine<Size>(own, opponent, memo));
+                        }
+                    }
+                }
+                return result;
+            }();
+            return table;
+        }
+
+        template<int32_t Size>
+        uint32_t GatherColumn(uint64_t bits, int32_t col) {
+#ifdef __BMI2__
+            return static_cast<uint32_t>(_pext_u64(bits, FIRST_COLUMN<Size> << col));
+#else
+            uint32_t line = 0;
+            for (int32_t row = 0; row < Size; ++row) {
+                line |= static_cast<uint32_t>((bits >> Geometry<Size>::Square(row, col)) & 1)
+                        << row;
+            }
+            return line;
+#endif
+        }
+
+        template<int32_t Size>
+        uint64_t ScatterColumn(uint32_t line, int32_t col) {
+#ifdef __BMI2__
+            return _pdep_u64(line, FIRST_COLUMN<Size> << col);
+#else
+            uint64_t bits = 0;
+            for (; line; line &= line - 1) {
+                bits |= Geometry<Size>::Bit(std::countr_zero(line), col);
+            }
+            return bits;
+#endif
+        }
+
+        template<int32_t Size>
+        uint64_t StableEdges(uint64_t own, uint64_t opponent) {
+            const auto& table = EdgeTable<Size>();
+            auto lookup = [&](uint32_t own_line, uint32_t opponent_line) {
+                return table[(own_line << Size) | opponent_line];
+            };
+            constexpr int32_t last = Size * (Size - 1);
+            uint64_t stable = lookup(own & LINE<Size>, opponent & LINE<Size>);
+            stable |= uint64_t{lookup(static_cast<uint32_t>(own >> last),
+                                      static_cast<uint32_t>(opponent >> last))}
+                      << last;
+            for (int32_t col : {0, Size - 1}) {
+                stable |= ScatterColumn<Size>(lookup(GatherColumn<Size>(own, col),
+                                                     GatherColumn<Size>(opponent, col)),
+                                              col);
+            }
+            return stable;
+        }
+    }// namespace
+
+    template<int32_t Size>
+    uint64_t StableDiscs(uint64_t own, uint64_t opponent) {
+        using G = Geometry<Size>;
+        uint64_t filled = own | opponent;
+        uint64_t empty = G::ALL & ~filled;
+        uint64_t not_first = G::ALL & ~FIRST_COLUMN<Size>;
+        uint64_t not_last = G::ALL & ~(FIRST_COLUMN<Size> << (Size - 1));
+        uint64_t full_rows = FullLines<1>(empty, not_first, not_last);
+        uint64_t full_columns = FullLines<Size>(empty, G::ALL, G::ALL);
+        uint64_t full_diagonals = FullLines<Size + 1>(empty, not_first, not_last);
+        uint64_t full_anti_diagonals = FullLines<Size - 1>(empty, not_last, not_first);
+
+        // Shifts from a central square never wrap to the other side of the board.
+        uint64_t central = own & G::INNER_COLUMNS & ~uint64_t{LINE<Size>} & ~LAST_ROW<Size>;
+        uint64_t stable = StableEdges<Size>(own, opponent) |
+                          (central & full_rows & full_columns & full_diagonals &
+                           full_anti_diagonals);
+        if (stable == 0) {
+            return 0;
+        }
+        uint64_t previous;
+        do {
+            previous = stable;
+            uint64_t rows = (stable >> 1) | (stable << 1) | full_rows;
+            uint64_t columns_stable = (stable >> Size) | (stable << Size) | full_columns;
+            uint64_t diagonals = (stable >> (Size + 1)) | (stable << (Size + 1)) |
+                                 full_diagonals;
+            uint64_t anti_diagonals = (stable >> (Size - 1)) | (stable << (Size - 1)) |
+                                      full_anti_diagonals;
+            stable |= central & rows & columns_stable & diagonals & anti_diagonals;
+        } while (stable != previous);
+        return stable;
+    }
+
+    template uint64_t StableDiscs<4>(uint64_t own, uint64_t opponent);
+    template uint64_t StableDiscs<6>(uint64_t own, uint64_t opponent);
+    template uint64_t StableDiscs<8>(uint64_t own, uint64_t opponent);
+
+}// namespace ReversiEngine
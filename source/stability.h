@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstdint>
+
+namespace ReversiEngine {
+
+    // Discs of `own` that can not be flipped for the rest of the game on a Size x Size board
+    // (squares numbered as in Geometry). A subset of the truly stable discs: edge discs come
+    // from a table that tries every way to fill the edge, other discs are stable when each of
+    // their four lines is full or has a stable own disc next to them.
+    template<int32_t Size>
+    [[nodiscard]] uint64_t StableDiscs(uint64_t own, uint64_t opponent);
+
+    extern template uint64_t StableDiscs<4>(uint64_t own, uint64_t opponent);
+    extern template uint64_t StableDiscs<6>(uint64_t own, uint64_t opponent);
+    extern template uint64_t StableDiscs<8>(uint64_t own, uint64_t opponent);
+
+}// namespace ReversiEngine
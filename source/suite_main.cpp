@@ -0,0 +1,318 @@
+#include "arguments.h"
+#include "board.h"
+#include "engine.h"
+#include "evaluation.h"
+#include "json.h"
+#include "notation.h"
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <thread>
+
+namespace ReversiEngine {
+
+    namespace {
+        struct SuitePosition {
+            int32_t id = 0;
+            std::string text;
+            Board board;
+            // Known moves with their exact scores; scores are absent in move-only midgame sets.
+            std::vector<std::pair<Cell, std::optional<int32_t>>> expected;
+        };
+
+        // A position of a --baseline report.
+        struct BaselineResult {
+            double seconds = 0;
+            int64_t nodes = 0;
+            bool correct = false;
+        };
+
+        struct SuiteResult {
+            Cell move{-1, -1};
+            int32_t score = 0;
+            bool finished = false;
+            bool correct = false;
+            double seconds = 0;
+            int64_t nodes = 0;
+        };
+
+        // The whole of `text` as a number.
+        template<typename T>
+        bool ParseNumber(const std::string& text, T& value) {
+            std::istringstream in(text);
+            return in >> value && (in >> std::ws).eof();
+        }
+
+        // "<64 squares from a1 to h8: X, O or -> <side to move X|O>; <move>:<score>; ..." as in
+        // the FFO/obf endgame files. X is the first player.
+        bool ParseSuiteLine(const std::string& line, SuitePosition& position) {
+            if (!ParsePosition(line, position.board)) {
+                return false;
+            }
+            position.text = line.substr(0, POSITION_TEXT_LENGTH);
+            std::istringstream rest(line.substr(POSITION_TEXT_LENGTH));
+            std::string entry;
+            while (std::getline(rest, entry, ';')) {
+                entry.erase(0, entry.find_first_not_of(' '));
+                entry.erase(entry.find_last_not_of(" \r") + 1);
+                if (entry.empty()) {
+                    continue;
+                }
+                auto cell = ParseCell(entry.substr(0, 2));
+                if (!cell) {
+                    return false;
+                }
+                std::optional<int32_t> score;
+                if (entry.size() > 3 && entry[2] == ':') {
+                    int32_t value = 0;
+                    if (!ParseNumber(entry.substr(3), value)) {
+                        return false;
+                    }
+                    score = value;
+                }
+                position.expected.emplace_back(*cell, score);
+            }
+            return true;
+        }
+
+        bool LoadSuite(const std::string& path, std::vector<SuitePosition>& positions) {
+            std::ifstream in(path);
+            if (!in) {
+                return false;
+            }
+            std::string line;
+            while (std::getline(in, line)) {
+                if (line.empty() || line[0] == '#' || line[0] == '%') {
+                    continue;
+                }
+                SuitePosition position;
+                position.id = static_cast<int32_t>(positions.size()) + 1;
+                if (!ParseSuiteLine(line, position)) {
+                    std::cerr << "Can not parse suite line: " << line << std::endl;
+                    return false;
+                }
+                positions.push_back(position);
+            }
+            return true;
+        }
+
+        // Reads a --report file of an earlier run, by position id.
+        bool LoadBaseline(const std::string& path, std::map<int32_t, BaselineResult>& baseline) {
+            std::ifstream in(path);
+            if (!in) {
+                return false;
+            }
+            std::string line;
+            while (std::getline(in, line)) {
+                if (line.find_first_not_of(" \r") == std::string::npos) {
+                    continue;
+                }
+                int32_t id = 0;
+                BaselineResult result;
+                std::string correct = JsonField(line, "correct");
+                if (!ParseNumber(JsonField(line, "id"), id) ||
+                    !ParseNumber(JsonField(line, "seconds"), result.seconds) ||
+                    !ParseNumber(JsonField(line, "nodes"), result.nodes) ||
+                    (correct != "true" && correct != "false")) {
+                    std::cerr << "Can not parse baseline line: " << line << std::endl;
+                    return false;
+                }
+                result.correct = correct == "true";
+                baseline[id] = result;
+            }
+            return !baseline.empty();
+        }
+
+        // A solved position is correct if the score is the best known one and the move is not
+        // listed with a worse score. A searched position is correct if the move is one of the
+        // listed best moves.
+        bool IsCorrect(const SuitePosition& position, const SearchResult& search, bool exact) {
+            std::optional<int32_t> best_score;
+            for (const auto& [cell, score] : position.expected) {
+                if (score && (!best_score || *score > *best_score)) {
+                    best_score = score;
+                }
+            }
+            if (exact && best_score && search.score != *best_score) {
+                return false;
+            }
+            for (const auto& [cell, score] : position.expected) {
+                if (cell == search.move) {
+                    return !best_score || (score && *score == *best_score);
+                }
+            }
+            return position.expected.empty() || (exact && best_score);
+        }
+
+        std::string ToJson(const SuitePosition& position, const SuiteResult& result,
+                           bool exact) {
+            std::ostringstream out;
+            out << "{\"id\": " << position.id << ", \"position\": \"" << position.text
+                << "\", \"mode\": \"" << (exact ? "solve" : "search") << "\", \"move\": \""
+                << result.move << "\", \"score\": " << result.score
+                << ", \"finished\": " << (result.finished ? "true" : "false")
+                << ", \"correct\": " << (result.correct ? "true" : "false")
+                << ", \"seconds\": " << result.seconds << ", \"nodes\": " << result.nodes
+                << ", \"nodes_per_sec\": "
+                << static_cast<int64_t>(static_cast<double>(result.nodes) /
+                                        std::max(result.seconds, 1e-9))
+                << "}";
+            return out.str();
+        }
+    }// namespace
+
+    int RunSuite(const Arguments& arguments) {
+        if (arguments.Positional().empty()) {
+            std::cerr << "No suite file given" << std::endl;
+            return 1;
+        }
+        Board().InitPrecalc();
+        if (arguments.Has("weights") &&
+            !LoadEvaluationWeights(arguments.GetString("weights", ""))) {
+            std::cerr << "Can not load evaluation weights" << std::endl;
+            return 1;
+        }
+        std::vector<SuitePosition> positions;
+        if (!LoadSuite(arguments.Positional().front(), positions)) {
+            std::cerr << "Can not load " << arguments.Positional().front() << std::endl;
+            return 1;
+        }
+        // With --depth the positions are searched with the evaluation (midgame sets), otherwise
+        // they are solved exactly.
+        bool exact = !arguments.Has("depth");
+        SearchLimits limits;
+        limits.depth = static_cast<int32_t>(arguments.GetInt("depth", limits.depth));
+        limits.nodes = arguments.GetInt("nodes", 0);
+        limits.milliseconds = arguments.GetInt("time", 0);
+        auto threads = static_cast<int32_t>(arguments.GetInt("threads", 1));
+        double tolerance = arguments.GetDouble("tolerance", 0.1);
+
+        std::map<int32_t, BaselineResult> baseline;
+        if (arguments.Has("baseline") &&
+            !LoadBaseline(arguments.GetString("baseline", ""), baseline)) {
+            std::cerr << "Can not load baseline " << arguments.GetString("baseline", "")
+                      << std::endl;
+            return 1;
+        }
+        std::ofstream report;
+        if (arguments.Has("report")) {
+            report.open(arguments.GetString("report", ""));
+            if (!report) {
+                std::cerr << "Can not write " << arguments.GetString("report", "") << std::endl;
+                return 1;
+            }
+        }
+
+        std::vector<SuiteResult> results(positions.size());
+        std::atomic<size_t> next_position = 0;
+        std::mutex output_mutex;
+        auto worker = [&]() {
+            Engine engine;
+            for (size_t i = next_position++; i < positions.size(); i = next_position++) {
+                auto start = std::chrono::steady_clock::now();
+                SearchResult search = exact ? engine.Solve(positions[i].board, limits)
+                                            : engine.Search(positions[i].board, limits);
+                std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+                SuiteResult& result = results[i];
+                result.move = search.move;
+                result.score = search.score;
+                result.finished = search.depth > 0;
+                result.correct = result.finished && IsCorrect(positions[i], search, exact);
+                result.seconds = elapsed.count();
+                result.nodes = search.nodes;
+                std::lock_guard lock(output_mutex);
+                std::cout << "#" << positions[i].id << ": " << result.move << " "
+                          << result.score << (result.correct ? " ok" : " WRONG") << " ("
+                          << result.seconds << " sec, " << result.nodes << " nodes)" << std::endl;
+            }
+        };
+        std::vector<std::jthread> workers;
+        for (int32_t i = 0; i < threads; ++i) {
+            workers.emplace_back(worker);
+        }
+        workers.clear();
+
+        // Searches without a time limit are deterministic, so their node counts must match the
+        // baseline exactly. Per-position times are too noisy to compare; the speed is compared
+        // over all positions in the baseline instead.
+        bool exact_nodes = limits.milliseconds == 0;
+        int32_t correct = 0;
+        int32_t regressions = 0;
+        double seconds = 0;
+        int64_t nodes = 0;
+        double baseline_seconds = 0;
+        int64_t baseline_nodes = 0;
+        double matched_seconds = 0;
+        int64_t matched_nodes = 0;
+        for (size_t i = 0; i < positions.size(); ++i) {
+            const SuiteResult& result = results[i];
+            correct += result.correct;
+            seconds += result.seconds;
+            nodes += result.nodes;
+            if (report.is_open()) {
+                report << ToJson(positions[i], result, exact) << "\n";
+            }
+            auto it = baseline.find(positions[i].id);
+            if (it == baseline.end()) {
+                continue;
+            }
+            const BaselineResult& old = it->second;
+            baseline_seconds += old.seconds;
+            baseline_nodes += old.nodes;
+            matched_seconds += result.seconds;
+            matched_nodes += result.nodes;
+            bool now_wrong = old.correct && !result.correct;
+            bool nodes_changed = exact_nodes && result.nodes != old.nodes;
+            if (now_wrong || nodes_changed) {
+                ++regressions;
+                std::cout << "Regression #" << positions[i].id << ": " << old.nodes << " -> "
+                          << result.nodes << " nodes" << (now_wrong ? ", now wrong" : "")
+                          << std::endl;
+            }
+        }
+        if (report.is_open() && !report.flush()) {
+            std::cerr << "Can not write " << arguments.GetString("report", "") << std::endl;
+            return 1;
+        }
+        std::cout << "Correct: " << correct << "/" << positions.size() << ", " << seconds
+                  << " sec, " << nodes << " nodes, "
+                  << static_cast<int64_t>(static_cast<double>(nodes) / std::max(seconds, 1e-9))
+                  << " nodes/sec" << std::endl;
+        if (!baseline.empty()) {
+            double old_speed = static_cast<double>(baseline_nodes) /
+                               std::max(baseline_seconds, 1e-9);
+            double speed = static_cast<double>(matched_nodes) / std::max(matched_seconds, 1e-9);
+            if (speed < old_speed * (1 - tolerance)) {
+                ++regressions;
+                std::cout << "Regression in speed: " << static_cast<int64_t>(old_speed) << " -> "
+                          << static_cast<int64_t>(speed) << " nodes/sec" << std::endl;
+            }
+            std::cout << "Regressions against baseline: " << regressions << std::endl;
+        }
+        return correct == static_cast<int32_t>(positions.size()) && regressions == 0 ? 0 : 1;
+    }
+
+}// namespace ReversiEngine
+
+int main(int argc, char** argv) {
+    ReversiEngine::Arguments arguments(argc, argv);
+    if (arguments.Has("help") || arguments.Positional().empty()) {
+        std::cout << "Usage: reversi-suite FILE [--depth=N] [--nodes=N] [--time=MS] [--threads=N]\n"
+                     "                     [--report=FILE] [--baseline=FILE] [--tolerance=0.1]\n"
+                     "                     [--weights=FILE]\n"
+                     "Solves every position of an obf file exactly (or searches it to --depth)\n"
+                     "and checks the best move. --report writes one JSON object per position;\n"
+                     "--baseline compares against such a report and flags newly wrong answers,\n"
+                     "node counts that differ (unless --time is given) and a drop in the overall\n"
+                     "nodes/sec beyond the tolerance."
+                  << std::endl;
+        return arguments.Has("help") ? 0 : 1;
+    }
+    return ReversiEngine::RunSuite(arguments);
+}
@@ -1,14 +1,17 @@
+#pragma once
+
 #include <chrono>
 #include <functional>
 #include <iomanip>
+#include <tuple>
 #include <type_traits>
+#include <utility>
 
 namespace ReversiEngine {
     struct Time {
         double seconds;
 
-        explicit Time(clock_t clock)
-            : seconds(static_cast<double>(clock) / static_cast<double>(CLOCKS_PER_SEC)) {
+        explicit Time(std::chrono::duration<double> duration) : seconds(duration.count()) {
         }
 
         Time& operator+=(const Time& other) {
@@ -25,20 +28,23 @@ namespace ReversiEngine {
         }
     };
 
+    // Wall-clock time of the call, so work spread over several threads is not over-counted.
     template<typename Function, typename... Args>
     auto MeasureFunction(Function&& function, Args&&... args) {
-        const clock_t start_time = ::clock();
-        if constexpr (std::is_same<typename std::result_of<Function(Args...)>::type, void>::value) {
-            std::invoke(function, args...);
-            return Time(::clock() - start_time);
+        const auto start_time = std::chrono::steady_clock::now();
+        if constexpr (std::is_void_v<std::invoke_result_t<Function, Args...>>) {
+            std::invoke(std::forward<Function>(function), std::forward<Args>(args)...);
+            return Time(std::chrono::steady_clock::now() - start_time);
         } else {
-            auto result = std::invoke(function, args...);
-            return std::make_tuple(result, Time(::clock() - start_time));
+            auto result =
+                    std::invoke(std::forward<Function>(function), std::forward<Args>(args)...);
+            return std::make_tuple(std::move(result),
+                                   Time(std::chrono::steady_clock::now() - start_time));
         }
     }
 
     template<typename Object, typename Method, typename... Args>
     auto MeasureMethod(Object&& object, Method&& method, Args&&... args) {
-        return MeasureFunction(method, &object, args...);
+        return MeasureFunction(std::forward<Method>(method), &object, std::forward<Args>(args)...);
     }
 }// namespace ReversiEngine
@@ -0,0 +1,145 @@
+#include "timing.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+namespace ReversiEngine {
+
+    namespace {
+        const std::array<const char*, static_cast<size_t>(TimedRegion::Count)> REGION_NAMES = {
+                "movegen",
+                "make",
+                "eval",
+                "tt probe",
+        };
+
+        std::mutex finished_mutex;
+        RegionTimings finished_timings;
+
+        struct ThreadTimings {
+            RegionTimings timings;
+
+            ~ThreadTimings() {
+                std::lock_guard lock(finished_mutex);
+                for (size_t i = 0; i < timings.size(); ++i) {
+                    finished_timings[i] += timings[i];
+                }
+            }
+        };
+
+        thread_local ThreadTimings thread_timings;
+    }// namespace
+
+    double NanosecondsPerTick() {
+        static const double nanoseconds_per_tick = []() {
+            if (!TicksAreCycles()) {
+                return 1.0;
+            }
+            auto start_time = std::chrono::steady_clock::now();
+            uint64_t start_ticks = ReadTicks();
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            uint64_t ticks = ReadTicks() - start_ticks;
+            std::chrono::duration<double, std::nano> elapsed =
+                    std::chrono::steady_clock::now() - start_time;
+            return elapsed.count() / static_cast<double>(std::max<uint64_t>(ticks, 1));
+        }();
+        return nanoseconds_per_tick;
+    }
+
+    void LatencyHistogram::Add(uint64_t ticks) {
+        int32_t bucket;
+        if (ticks < LINEAR) {
+            bucket = static_cast<int32_t>(ticks);
+        } else {
+            int32_t exponent = std::bit_width(ticks) - 1;
+            auto sub_bucket = static_cast<int32_t>((ticks >> (exponent - 3)) & (SUB_BUCKETS - 1));
+            bucket = LINEAR + (exponent - 4) * SUB_BUCKETS + sub_bucket;
+        }
+        ++buckets_[bucket];
+        ++count_;
+        total_ += ticks;
+    }
+
+    LatencyHistogram& LatencyHistogram::operator+=(const LatencyHistogram& other) {
+        for (size_t i = 0; i < buckets_.size(); ++i) {
+            buckets_[i] += other.buckets_[i];
+        }
+        count_ += other.count_;
+        total_ += other.total_;
+        return *this;
+    }
+
+    uint64_t LatencyHistogram::Count() const {
+        return count_;
+    }
+
+    uint64_t LatencyHistogram::Total() const {
+        return total_;
+    }
+
+    uint64_t LatencyHistogram::Quantile(double fraction) const {
+        if (count_ == 0) {
+            return 0;
+        }
+        // The rank of that latency among the samples, from 1.
+        auto target = std::clamp<uint64_t>(
+                static_cast<uint64_t>(std::ceil(fraction * static_cast<double>(count_))), 1,
+                count_);
+        uint64_t seen = 0;
+        for (int32_t bucket = 0; bucket < BUCKETS; ++bucket) {
+            seen += buckets_[bucket];
+            if (seen >= target) {
+                if (bucket < LINEAR) {
+                    return static_cast<uint64_t>(bucket);
+                }
+                int32_t exponent = (bucket - LINEAR) / SUB_BUCKETS + 4;
+                uint64_t sub_bucket = (bucket - LINEAR) % SUB_BUCKETS;
+                // The upper end of the bucket.
+                return ((SUB_BUCKETS + sub_bucket + 1) << (exponent - 3)) - 1;
+            }
+        }
+        return 0;
+    }
+
+    void RecordTiming(TimedRegion region, uint64_t ticks) {
+        thread_timings.timings[static_cast<size_t>(region)].Add(ticks);
+    }
+
+    RegionTimings CollectTimings() {
+        std::lock_guard lock(finished_mutex);
+        RegionTimings timings = finished_timings;
+        for (size_t i = 0; i < timings.size(); ++i) {
+            timings[i] += thread_timings.timings[i];
+        }
+        return timings;
+    }
+
+    std::string FormatTimings(const RegionTimings& timings) {
+        std::ostringstream out;
+        double nanoseconds_per_tick = NanosecondsPerTick();
+        auto nanoseconds = [&](uint64_t ticks) {
+            return static_cast<double>(ticks) * nanoseconds_per_tick;
+        };
+        for (size_t i = 0; i < timings.size(); ++i) {
+            const LatencyHistogram& histogram = timings[i];
+            if (histogram.Count() == 0) {
+                continue;
+            }
+            out << REGION_NAMES[i] << ": " << histogram.Count() << " calls, "
+                << nanoseconds(histogram.Total()) / 1e9 << " sec, p50 "
+                << nanoseconds(histogram.Quantile(0.5)) << " ns, p99 "
+                << nanoseconds(histogram.Quantile(0.99)) << " ns";
+            if (TicksAreCycles()) {
+                out << " (p50 " << histogram.Quantile(0.5) << ", p99 " << histogram.Quantile(0.99)
+                    << " cycles)";
+            }
+            out << "\n";
+        }
+        return out.str();
+    }
+
+}// namespace ReversiEngine
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Scoped timers of the hot search regions are only compiled in with the SCOPED_TIMERS build
+// option; without it the macro expands to nothing.
+#ifdef REVERSI_SCOPED_TIMERS
+#define SCOPED_TIMER(region)                                                                       \
+    ::ReversiEngine::ScopedTimer scoped_timer_##region(::ReversiEngine::TimedRegion::region)
+#else
+#define SCOPED_TIMER(region)
+#endif
+
+namespace ReversiEngine {
+
+    enum class TimedRegion { MoveGeneration, MakeMove, Evaluation, TableProbe, Count };
+
+    // A monotonic timestamp: time stamp counter cycles on x86, steady_clock nanoseconds
+    // elsewhere.
+    inline uint64_t ReadTicks() {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                             std::chrono::steady_clock::now().time_since_epoch())
+                                             .count());
+#endif
+    }
+
+    [[nodiscard]] constexpr bool TicksAreCycles() {
+#if defined(__x86_64__) || defined(__i386__)
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    // Measured against steady_clock on the first call.
+    [[nodiscard]] double NanosecondsPerTick();
+
+    // Latencies in ticks, exact below 16 and within 1/8 of the value above.
+    class LatencyHistogram {
+    public:
+        void Add(uint64_t ticks);
+
+        LatencyHistogram& operator+=(const LatencyHistogram& other);
+
+        [[nodiscard]] uint64_t Count() const;
+
+        [[nodiscard]] uint64_t Total() const;
+
+        // The smallest latency that at least a `fraction` of the samples do not exceed, rounded
+        // up to the end of its bucket.
+        [[nodiscard]] uint64_t Quantile(double fraction) const;
+
+    private:
+        static constexpr int32_t LINEAR = 16;
+        static constexpr int32_t SUB_BUCKETS = 8;
+        static constexpr int32_t BUCKETS = LINEAR + (64 - 4) * SUB_BUCKETS;
+
+        std::array<uint64_t, BUCKETS> buckets_{};
+        uint64_t count_ = 0;
+        uint64_t total_ = 0;
+    };
+
+    // Adds a sample to the calling thread's histogram of `region`. A thread's histograms are
+    // added to the process totals when it exits.
+    void RecordTiming(TimedRegion region, uint64_t ticks);
+
+    class ScopedTimer {
+    public:
+        explicit ScopedTimer(TimedRegion region) : region_(region), start_(ReadTicks()) {
+        }
+
+        ~ScopedTimer() {
+            RecordTiming(region_, ReadTicks() - start_);
+        }
+
+        ScopedTimer(const ScopedTimer&) = delete;
+
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    private:
+        TimedRegion region_;
+        uint64_t start_;
+    };
+
+    using RegionTimings =
+            std::array<LatencyHistogram, static_cast<size_t>(TimedRegion::Count)>;
+
+    // Histograms of the threads that have exited and of the calling thread.
+    [[nodiscard]] RegionTimings CollectTimings();
+
+    // One line per timed region with the count, total time, p50 and p99 in nanoseconds (and
+    // cycles where ticks are cycles); empty if nothing was timed.
+    [[nodiscard]] std::string FormatTimings(const RegionTimings& timings);
+
+}// namespace ReversiEngine
@@ -0,0 +1,205 @@
+#include "arguments.h"
+#include "board.h"
+#include "notation.h"
+#include "search_trace.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ReversiEngine {
+
+    namespace {
+        struct TracedSearch {
+            Board root;
+            bool has_root = false;
+            PackedPosition packed_root{};
+            // Which halves of packed_root were read, one bit per Search or Root record.
+            uint32_t root_parts = 0;
+            bool gaps = false;
+            std::vector<TraceRecord> nodes;
+        };
+
+        struct TraceNode {
+            TraceRecord record;
+            std::vector<TraceNode> children;
+        };
+
+        Cell MoveCell(int8_t move) {
+            return move < 0 ? Cell{-1, -1} : Cell{move >> 3, move & 7};
+        }
+
+        // Splits the records by search. The records of one search are in order, but those of
+        // searches by different engines may be interleaved.
+        std::map<uint32_t, TracedSearch> GroupSearches(const std::vector<TraceRecord>& records) {
+            std::map<uint32_t, TracedSearch> searches;
+            for (const TraceRecord& record : records) {
+                TracedSearch& search = searches[record.search];
+                search.gaps |= (record.flags & TraceRecord::AfterGap) != 0;
+                if (record.kind == TraceRecord::Node) {
+                    search.nodes.push_back(record);
+                    continue;
+                }
+                int32_t part = record.kind == TraceRecord::Search ? 0 : 1;
+                std::memcpy(search.packed_root.data() + part * TraceRecord::ROOT_BYTES,
+                            record.RootBytes(), TraceRecord::ROOT_BYTES);
+                search.root_parts |= 1u << part;
+            }
+            for (auto& [id, search] : searches) {
+                search.has_root =
+                        search.root_parts == 3 && UnpackPosition(search.packed_root, search.root);
+            }
+            return searches;
+        }
+
+        // Rebuilds the tree of the iteration that ends with the root record nodes[end]. Nodes
+        // whose parent was dropped from a full buffer are left out.
+        TraceNode BuildTree(const std::vector<TraceRecord>& nodes, size_t end) {
+            size_t begin = end;
+            while (begin > 0 && nodes[begin - 1].ply != 0) {
+                --begin;
+            }
+            std::vector<std::vector<TraceNode>> pending(256);
+            for (size_t i = begin; i <= end; ++i) {
+                const TraceRecord& record = nodes[i];
+                TraceNode node{record, {}};
+                if (record.ply + 1 < static_cast<int32_t>(pending.size())) {
+                    node.children = std::move(pending[record.ply + 1]);
+                    for (size_t ply = record.ply + 1; ply < pending.size(); ++ply) {
+                        pending[ply].clear();
+                    }
+                }
+                pending[record.ply].push_back(std::move(node));
+            }
+            return std::move(pending[0].back());
+        }
+
+        void PrintTree(const TraceNode& node, int32_t level, int32_t max_level) {
+            const TraceRecord& record = node.record;
+            std::cout << std::string(2 * level, ' ');
+            if (record.ply == 0) {
+                std::cout << "root";
+            } else {
+                std::cout << MoveCell(record.move);
+            }
+            std::cout << " depth=" << static_cast<int32_t>(record.depth) << " window=["
+                      << record.alpha << ", " << record.beta << "] score=" << record.score;
+            if (record.flags & TraceRecord::TableCutoff) {
+                std::cout << " table";
+            }
+            if (record.flags & TraceRecord::Stopped) {
+                std::cout << " stopped";
+            }
+            if (record.flags & TraceRecord::AfterGap) {
+                std::cout << " after-gap";
+            }
+            if (level == max_level && !node.children.empty()) {
+                std::cout << " (" << node.children.size() << " children)";
+            }
+            std::cout << "\n";
+            if (level < max_level) {
+                for (const auto& child : node.children) {
+                    PrintTree(child, level + 1, max_level);
+                }
+            }
+        }
+
+        void ListSearches(const std::map<uint32_t, TracedSearch>& searches) {
+            for (const auto& [id, search] : searches) {
+                std::cout << id << " ";
+                if (search.has_root) {
+                    auto text = FormatPosition(search.root);
+                    std::cout.write(text.data(), static_cast<std::streamsize>(text.size()));
+                } else {
+                    std::cout << "?";
+                }
+                std::cout << " depths";
+                for (const auto& record : search.nodes) {
+                    if (record.ply == 0) {
+                        std::cout << " " << static_cast<int32_t>(record.depth);
+                    }
+                }
+                std::cout << ", " << search.nodes.size() << " nodes"
+                          << (search.gaps ? " (records dropped)" : "") << "\n";
+            }
+        }
+    }// namespace
+
+    int RunTrace(const Arguments& arguments) {
+        std::vector<TraceRecord> records;
+        const std::string& path = arguments.Positional().front();
+        if (!ReadTrace(path, records)) {
+            std::cerr << "Can not read trace " << path << std::endl;
+            return 1;
+        }
+        auto searches = GroupSearches(records);
+        if (!arguments.Has("search")) {
+            ListSearches(searches);
+            return 0;
+        }
+
+        auto found = searches.find(static_cast<uint32_t>(arguments.GetInt("search", 0)));
+        if (found == searches.end()) {
+            std::cerr << "No search " << arguments.GetInt("search", 0) << std::endl;
+            return 1;
+        }
+        const TracedSearch& search = found->second;
+        // The last iteration unless --iteration picks another depth.
+        auto depth = arguments.GetInt("iteration", 0);
+        size_t end = search.nodes.size();
+        for (size_t i = 0; i < search.nodes.size(); ++i) {
+            if (search.nodes[i].ply == 0 && (depth == 0 || search.nodes[i].depth == depth)) {
+                end = i;
+            }
+        }
+        if (end == search.nodes.size()) {
+            std::cerr << "No finished iteration" << std::endl;
+            return 1;
+        }
+        TraceNode node = BuildTree(search.nodes, end);
+
+        // Follows --path, two characters per move and "--" for a pass.
+        std::string moves = arguments.GetString("path", "");
+        for (size_t i = 0; i + 1 < moves.size(); i += 2) {
+            std::string_view text(moves.data() + i, 2);
+            auto cell = text == "--" ? std::optional<Cell>(Cell{-1, -1}) : ParseCell(text);
+            auto child = cell ? std::find_if(node.children.begin(), node.children.end(),
+                                             [&](const TraceNode& candidate) {
+                                                 return MoveCell(candidate.record.move) == *cell;
+                                             })
+                              : node.children.end();
+            if (child == node.children.end()) {
+                std::cerr << "No traced node " << moves.substr(0, i + 2) << std::endl;
+                return 1;
+            }
+            TraceNode next = std::move(*child);
+            node = std::move(next);
+        }
+        PrintTree(node, 0, static_cast<int32_t>(arguments.GetInt("max-ply", 2)));
+        return 0;
+    }
+
+}// namespace ReversiEngine
+
+int main(int argc, char** argv) {
+    ReversiEngine::Arguments arguments(argc, argv);
+    if (arguments.Has("help") || arguments.Positional().empty()) {
+        std::cout << "Usage: reversi-trace FILE [--search=ID [--iteration=DEPTH] [--path=MOVES]\n"
+                     "                           [--max-ply=2]]\n"
+                     "Lists the searches of a trace written with --trace by reversi or\n"
+                     "reversi-analyze: the root position, the depths of the finished iterations\n"
+                     "and the number of traced nodes. With --search it prints the tree of an\n"
+                     "iteration (the last by default) from the node reached by --path (such as\n"
+                     "d3c5, -- for a pass) down to --max-ply plies, each node with its depth,\n"
+                     "search window and score from the side to move. Nodes one ply above the\n"
+                     "leaves are not traced."
+                  << std::endl;
+        return arguments.Has("help") ? 0 : 1;
+    }
+    return ReversiEngine::RunTrace(arguments);
+}
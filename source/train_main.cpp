@@ -0,0 +1,253 @@
+#include "arguments.h"
+#include "board.h"
+#include "evaluation.h"
+#include "game_record.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <thread>
+
+namespace ReversiEngine {
+
+    namespace {
+        constexpr int32_t CLASSES = EvaluationWeights::SQUARE_CLASSES;
+
+        using Features = std::array<double, CLASSES>;
+
+        // Normal equations of the least-squares fit of one stage: sum of x * x^T and x * y over
+        // the positions, with x the square-class features and y the final disc difference.
+        struct StageSums {
+            std::array<std::array<double, CLASSES>, CLASSES> xx{};
+            std::array<double, CLASSES> xy{};
+            double yy = 0;
+            int64_t positions = 0;
+
+            void Add(const Features& x, double y) {
+                for (int32_t i = 0; i < CLASSES; ++i) {
+                    for (int32_t j = 0; j < CLASSES; ++j) {
+                        xx[i][j] += x[i] * x[j];
+                    }
+                    xy[i] += x[i] * y;
+                }
+                yy += y * y;
+                ++positions;
+            }
+
+            StageSums& operator+=(const StageSums& other) {
+                for (int32_t i = 0; i < CLASSES; ++i) {
+                    for (int32_t j = 0; j < CLASSES; ++j) {
+                        xx[i][j] += other.xx[i][j];
+                    }
+                    xy[i] += other.xy[i];
+                }
+                yy += other.yy;
+                positions += other.positions;
+                return *this;
+            }
+        };
+
+        using Sums = std::array<StageSums, EvaluationWeights::STAGES>;
+
+        // Own minus opponent discs on every square class, from the side to move's view.
+        Features ExtractFeatures(const Board& board) {
+            Features features{};
+            Bitset64 own = board.OwnDiscs();
+            Bitset64 opponent = board.OpponentDiscs();
+            for (int32_t position = 0; position < 64; ++position) {
+                if (own[position]) {
+                    features[SquareClass(position)] += 1;
+                } else if (opponent[position]) {
+                    features[SquareClass(position)] -= 1;
+                }
+            }
+            return features;
+        }
+
+        void AddGame(const GameRecord& record, Sums& sums) {
+            Board board;
+            for (size_t i = 0; i < record.length; ++i) {
+                if (!ReplayMove(board, record.Move(i))) {
+                    return;
+                }
+                if (board.GameEnded()) {
+                    break;
+                }
+                double result = board.CurrentPlayer() == First ? record.result : -record.result;
+                int32_t discs = 64 - board.EmptyCount();
+                sums[EvaluationStage(discs)].Add(ExtractFeatures(board), result);
+            }
+        }
+
+        // Solves (xx + ridge * I) * beta = xy by Gaussian elimination with partial pivoting.
+        Features Solve(const StageSums& sums, double ridge) {
+            auto a = sums.xx;
+            Features beta = sums.xy;
+            for (int32_t i = 0; i < CLASSES; ++i) {
+                a[i][i] += ridge;
+            }
+            for (int32_t column = 0; column < CLASSES; ++column) {
+                int32_t pivot = column;
+                for (int32_t row = column + 1; row < CLASSES; ++row) {
+                    if (std::abs(a[row][column]) > std::abs(a[pivot][column])) {
+                        pivot = row;
+                    }
+                }
+                std::swap(a[column], a[pivot]);
+                std::swap(beta[column], beta[pivot]);
+                for (int32_t row = column + 1; row < CLASSES; ++row) {
+                    double factor = a[row][column] / a[column][column];
+                    for (int32_t k = column; k < CLASSES; ++k) {
+                        a[row][k] -= factor * a[column][k];
+                    }
+                    beta[row] -= factor * beta[column];
+                }
+            }
+            for (int32_t row = CLASSES - 1; row >= 0; --row) {
+                for (int32_t k = row + 1; k < CLASSES; ++k) {
+                    beta[row] -= a[row][k] * beta[k];
+                }
+                beta[row] /= a[row][row];
+            }
+            return beta;
+        }
+
+        // Root mean square error in discs of the prediction beta * x, from the sums alone.
+        double RootMeanSquareError(const StageSums& sums, const Features& beta) {
+            double error = sums.yy;
+            for (int32_t i = 0; i < CLASSES; ++i) {
+                error -= 2 * beta[i] * sums.xy[i];
+                for (int32_t j = 0; j < CLASSES; ++j) {
+                    error += beta[i] * beta[j] * sums.xx[i][j];
+                }
+            }
+            return std::sqrt(std::max(error, 0.0) / static_cast<double>(sums.positions));
+        }
+    }// namespace
+
+    int RunTraining(const Arguments& arguments) {
+        Board().InitPrecalc();
+        auto threads = static_cast<int32_t>(arguments.GetInt(
+                "threads", std::max(1u, std::thread::hardware_concurrency())));
+        double scale = arguments.GetDouble("scale", 32);
+        double ridge = arguments.GetDouble("ridge", 1);
+        std::string output = arguments.GetString("output", "weights.txt");
+        auto start = std::chrono::steady_clock::now();
+
+        std::vector<std::unique_ptr<GameReader>> readers;
+        // Every block of every file is one task; workers take them in turn and accumulate into
+        // their own sums.
+        std::vector<std::pair<const GameReader*, size_t>> tasks;
+        for (const auto& path : arguments.Positional()) {
+            readers.push_back(std::make_unique<GameReader>(path));
+            if (!readers.back()->IsOpen()) {
+                std::cerr << "Can not read " << path << std::endl;
+                return 1;
+            }
+            for (size_t block = 0; block < readers.back()->BlockCount(); ++block) {
+                tasks.emplace_back(readers.back().get(), block);
+            }
+        }
+        std::vector<Sums> thread_sums(threads);
+        std::atomic<size_t> next_task = 0;
+        std::atomic<int64_t> games = 0;
+        std::atomic<bool> failed = false;
+        auto worker = [&](Sums& sums) {
+            std::vector<GameRecord> records;
+            for (size_t i = next_task++; i < tasks.size(); i = next_task++) {
+                if (!tasks[i].first->ReadBlock(tasks[i].second, records)) {
+                    failed = true;
+                }
+                for (const auto& record : records) {
+                    AddGame(record, sums);
+                }
+                games += static_cast<int64_t>(records.size());
+            }
+        };
+        std::vector<std::jthread> workers;
+        for (int32_t i = 0; i < threads; ++i) {
+            workers.emplace_back(worker, std::ref(thread_sums[i]));
+        }
+        workers.clear();
+        if (failed) {
+            std::cerr << "Corrupt game file" << std::endl;
+            return 1;
+        }
+        Sums sums;
+        for (const auto& part : thread_sums) {
+            for (int32_t stage = 0; stage < EvaluationWeights::STAGES; ++stage) {
+                sums[stage] += part[stage];
+            }
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        int64_t positions = 0;
+        for (const auto& stage : sums) {
+            positions += stage.positions;
+        }
+        std::cout << "Games: " << games << ", positions: " << positions << ", "
+                  << elapsed.count() << " sec" << std::endl;
+        if (positions == 0) {
+            std::cerr << "No positions to train on" << std::endl;
+            return 1;
+        }
+
+        EvaluationWeights weights;
+        for (int32_t stage = 0; stage < EvaluationWeights::STAGES; ++stage) {
+            Features beta = Solve(sums[stage], ridge);
+            // Scale down if the weights would exceed the evaluation range.
+            double stage_scale = scale;
+            double max_evaluation = 0;
+            for (int32_t position = 0; position < 64; ++position) {
+                max_evaluation += std::abs(beta[SquareClass(position)]) * scale;
+            }
+            if (max_evaluation > EvaluationWeights::MAX_EVALUATION) {
+                stage_scale *= EvaluationWeights::MAX_EVALUATION / max_evaluation;
+            }
+            // Rounding can still push the sum past the range, which Load would reject.
+            while (true) {
+                for (int32_t i = 0; i < CLASSES; ++i) {
+                    weights.weights[stage][i] =
+                            static_cast<int32_t>(std::lround(beta[i] * stage_scale));
+                }
+                int32_t rounded = weights.MaxEvaluation(stage);
+                if (rounded <= EvaluationWeights::MAX_EVALUATION) {
+                    break;
+                }
+                stage_scale *= static_cast<double>(EvaluationWeights::MAX_EVALUATION) / rounded;
+            }
+            std::cout << "Stage " << stage << ": " << sums[stage].positions
+                      << " positions, error " << std::fixed << std::setprecision(2)
+                      << RootMeanSquareError(sums[stage], beta) << " discs, weights";
+            for (int32_t weight : weights.weights[stage]) {
+                std::cout << " " << weight;
+            }
+            std::cout << std::defaultfloat << std::endl;
+        }
+        if (!weights.Save(output)) {
+            std::cerr << "Can not write " << output << std::endl;
+            return 1;
+        }
+        std::cout << "Weights written to " << output << std::endl;
+        return 0;
+    }
+
+}// namespace ReversiEngine
+
+int main(int argc, char** argv) {
+    ReversiEngine::Arguments arguments(argc, argv);
+    if (arguments.Has("help") || arguments.Positional().empty()) {
+        std::cout << "Usage: reversi-train FILE... [--threads=N] [--output=weights.txt]\n"
+                     "                     [--scale=32] [--ridge=1]\n"
+                     "Fits the square-class evaluation weights of every stage to the final\n"
+                     "disc difference of the games (as written by reversi-match --output) by\n"
+                     "least squares. --scale is the evaluation units per disc, --ridge the\n"
+                     "regularization that keeps classes without data at zero."
+                  << std::endl;
+        return arguments.Has("help") ? 0 : 1;
+    }
+    return ReversiEngine::RunTraining(arguments);
+}
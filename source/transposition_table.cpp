@@ -0,0 +1,148 @@
+#include "transposition_table.h"
+
+#include <algorithm>
+#include <bit>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ReversiEngine {
+
+    namespace {
+        uint64_t Pack(const TranspositionTable::Entry& entry) {
+            return static_cast<uint64_t>(static_cast<uint16_t>(entry.score)) |
+                   static_cast<uint64_t>(entry.depth) << 16 |
+                   static_cast<uint64_t>(entry.bound) << 24 |
+                   static_cast<uint64_t>(entry.move) << 32;
+        }
+
+        TranspositionTable::Entry Unpack(uint64_t data) {
+            TranspositionTable::Entry entry;
+            entry.score = static_cast<int16_t>(data & 0xFFFF);
+            entry.depth = static_cast<uint8_t>(data >> 16);
+            entry.bound = static_cast<TranspositionTable::Bound>((data >> 24) & 3);
+            entry.move = static_cast<uint8_t>(data >> 32);
+            return entry;
+        }
+
+        size_t BucketCount(size_t bytes, size_t bucket_size) {
+            return std::bit_floor(std::max(bytes, bucket_size) / bucket_size);
+        }
+    }// namespace
+
+    TranspositionTable::TranspositionTable(size_t megabytes) {
+        Allocate(megabytes);
+    }
+
+    TranspositionTable::TranspositionTable(size_t megabytes, const std::string& shared_name) {
+        // Other processes see the entries through the same physical pages, so the atomics must
+        // not hide a lock in the process.
+        static_assert(std::atomic<uint64_t>::is_always_lock_free);
+#ifdef __linux__
+        int descriptor = shm_open(shared_name.c_str(), O_RDWR | O_CREAT, 0600);
+        if (descriptor >= 0) {
+            // The first process to take the lock sizes the segment; the kernel releases the lock
+            // of a process that dies, and a new segment reads as zeros, i.e. an empty table.
+            struct stat status {};
+            if (flock(descriptor, LOCK_EX) == 0) {
+                if (fstat(descriptor, &status) == 0 && status.st_size == 0) {
+                    size_t bytes = BucketCount(megabytes << 20, sizeof(Bucket)) * sizeof(Bucket);
+                    if (ftruncate(descriptor, static_cast<off_t>(bytes)) != 0) {
+                        status.st_size = 0;
+                    }
+                }
+                if (fstat(descriptor, &status) != 0) {
+                    status.st_size = 0;
+                }
+                flock(descriptor, LOCK_UN);
+            }
+            auto size = static_cast<size_t>(status.st_size);
+            if (size >= sizeof(Bucket)) {
+                size = BucketCount(size, sizeof(Bucket)) * sizeof(Bucket);
+                void* memory =
+                        mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+                if (memory != MAP_FAILED) {
+                    // Transparent huge pages for shared memory, where the kernel allows them.
+                    madvise(memory, size, MADV_HUGEPAGE);
+                    buckets_ = static_cast<Bucket*>(memory);
+                    mapped_bytes_ = size;
+                    mask_ = size / sizeof(Bucket) - 1;
+                }
+            }
+            close(descriptor);
+        }
+#endif
+        if (!buckets_) {
+            Allocate(megabytes);
+        }
+    }
+
+    TranspositionTable::~TranspositionTable() {
+#ifdef __linux__
+        if (mapped_bytes_ != 0) {
+            munmap(buckets_, mapped_bytes_);
+        }
+#endif
+    }
+
+    void TranspositionTable::Allocate(size_t megabytes) {
+        size_t buckets = BucketCount(megabytes << 20, sizeof(Bucket));
+        // Zeroed memory is an empty table, as for a new shared segment.
+        owned_ = HugePageBlock(buckets * sizeof(Bucket));
+        buckets_ = static_cast<Bucket*>(owned_.Data());
+        mask_ = buckets - 1;
+    }
+
+    void TranspositionTable::Clear() {
+        for (uint64_t i = 0; i <= mask_; ++i) {
+            for (auto& slot : buckets_[i].slots) {
+                slot.check.store(0, std::memory_order_relaxed);
+                slot.data.store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool TranspositionTable::Probe(uint64_t key, Entry& entry) const {
+        for (const auto& slot : buckets_[key & mask_].slots) {
+            uint64_t data = slot.data.load(std::memory_order_relaxed);
+            if ((slot.check.load(std::memory_order_relaxed) ^ data) == key) {
+                entry = Unpack(data);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void TranspositionTable::Store(uint64_t key, const Entry& entry) {
+        auto& slots = buckets_[key & mask_].slots;
+        Slot* target = nullptr;
+        for (auto& slot : slots) {
+            uint64_t data = slot.data.load(std::memory_order_relaxed);
+            if ((slot.check.load(std::memory_order_relaxed) ^ data) == key) {
+                target = &slot;
+                break;
+            }
+        }
+        if (!target) {
+            auto first = Unpack(slots[0].data.load(std::memory_order_relaxed));
+            target = first.depth <= entry.depth ? &slots[0] : &slots[1];
+        }
+        uint64_t data = Pack(entry);
+        target->data.store(data, std::memory_order_relaxed);
+        target->check.store(key ^ data, std::memory_order_relaxed);
+    }
+
+    size_t TranspositionTable::SizeInBytes() const {
+        return (mask_ + 1) * sizeof(Bucket);
+    }
+
+    bool TranspositionTable::Shared() const {
+        return mapped_bytes_ != 0;
+    }
+
+}// namespace ReversiEngine
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "huge_pages.h"
+
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <string>
+
+namespace ReversiEngine {
+
+    // Table key of the discs of the side to move and of its opponent.
+    [[nodiscard]] inline uint64_t PositionHash(uint64_t own, uint64_t opponent) {
+        uint64_t hash =
+                own * 0x9E3779B97F4A7C15ULL ^ std::rotl(opponent * 0xC2B2AE3D27D4EB4FULL, 32);
+        hash ^= hash >> 29;
+        hash *= 0xBF58476D1CE4E5B9ULL;
+        return hash ^ (hash >> 32);
+    }
+
+    // Hash table of search results shared by any number of engines. Entries are two 64-bit
+    // words written without locks; the first word holds the key xor-ed with the second, so an
+    // entry torn by a concurrent write does not match any key and reads as a miss.
+    //
+    // The same holds between processes: a table placed in a named shared-memory segment is
+    // used by every process that attaches to the name, and a process that dies in the middle of
+    // a write leaves at most one entry that reads as a miss.
+    class TranspositionTable {
+    public:
+        enum Bound : uint8_t { Exact, Lower, Upper };
+
+        // Square of the best move, NO_MOVE if unknown.
+        static constexpr uint8_t NO_MOVE = 64;
+
+        struct Entry {
+            int16_t score = 0;
+            uint8_t depth = 0;
+            Bound bound = Exact;
+            uint8_t move = NO_MOVE;
+        };
+
+        explicit TranspositionTable(size_t megabytes);
+
+        // Attaches to the POSIX shared-memory segment `shared_name` (such as "/reversi-tt"),
+        // creating it with the given size if it does not exist; an existing segment keeps its
+        // size. The segment outlives the processes; on Linux it is the file of that name in
+        // /dev/shm. Falls back to a private table if shared memory is unavailable, see Shared().
+        TranspositionTable(size_t megabytes, const std::string& shared_name);
+
+        ~TranspositionTable();
+
+        TranspositionTable(const TranspositionTable&) = delete;
+
+        TranspositionTable& operator=(const TranspositionTable&) = delete;
+
+        // Clears a shared table for every process attached to it.
+        void Clear();
+
+        [[nodiscard]] bool Probe(uint64_t key, Entry& entry) const;
+
+        // Replaces the entry of the same position if the bucket has one. Otherwise the first
+        // slot of the bucket is depth-preferred: it takes the new entry if that is at least as
+        // deep as its own, else the second slot, which always takes it.
+        void Store(uint64_t key, const Entry& entry);
+
+        [[nodiscard]] size_t SizeInBytes() const;
+
+        [[nodiscard]] bool Shared() const;
+
+    private:
+        struct Slot {
+            std::atomic<uint64_t> check{0};
+            std::atomic<uint64_t> data{0};
+        };
+
+        struct alignas(32) Bucket {
+            Slot slots[2];
+        };
+
+        void Allocate(size_t megabytes);
+
+        Bucket* buckets_ = nullptr;
+        HugePageBlock owned_;
+        size_t mapped_bytes_ = 0;// size of the shared mapping, 0 for a private table
+        uint64_t mask_ = 0;
+    };
+
+}// namespace ReversiEngine